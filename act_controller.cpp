@@ -10,636 +10,4265 @@
 #include <random> // added
 #include <cmath>  // added for std::abs
 #include <algorithm> // added for std::clamp
+#include <array>
+#include <memory>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <cstdlib>
+#include <cstdio>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <deque>
+#include <exception>
+#include <type_traits>
+#include <tuple>
+#include <functional>
+#ifndef _WIN32
+#include <termios.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#endif
+#ifdef __linux__
+#include <linux/serial.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/prctl.h>
+#include <cerrno>
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ACT_CRC16_HAVE_CLMUL 1
+#endif
+
+// Compile-time Modbus RTU frame builder.
+// Frames are std::array based and sealed with a constexpr CRC, so constant frames cost
+// nothing at runtime and a mistyped capture fails the build instead of being NAKed.
+namespace modbus {
+
+// CRC16 Modbus (A001 poly), bit-at-a-time; usable in constant expressions.
+constexpr uint16_t crc16(const uint8_t* data, std::size_t len, uint16_t crc = 0xFFFF) {
+    for (std::size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; ++j) {
+            if (crc & 0x0001) crc = static_cast<uint16_t>((crc >> 1) ^ 0xA001);
+            else crc = static_cast<uint16_t>(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+// Runtime CRC engines. All of them are bit-identical to crc16() above; crc16_fast()
+// picks the best one for this CPU once and is what the hot paths call.
+namespace detail {
+
+// slice[k][b] = CRC contribution of byte b followed by k zero bytes (reflected, A001).
+constexpr std::array<std::array<uint16_t, 256>, 8> make_crc16_slices() {
+    std::array<std::array<uint16_t, 256>, 8> t{};
+    for (unsigned b = 0; b < 256; ++b) {
+        uint16_t c = static_cast<uint16_t>(b);
+        for (int j = 0; j < 8; ++j)
+            c = (c & 1) ? static_cast<uint16_t>((c >> 1) ^ 0xA001) : static_cast<uint16_t>(c >> 1);
+        t[0][b] = c;
+    }
+    for (std::size_t k = 1; k < 8; ++k)
+        for (unsigned b = 0; b < 256; ++b)
+            t[k][b] = static_cast<uint16_t>((t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF]);
+    return t;
+}
+inline constexpr auto crc16_slices = make_crc16_slices();
+
+// x^n mod P for the normal-form Modbus polynomial (0x8005), used for CLMUL fold constants.
+constexpr uint64_t crc16_xpow_mod(unsigned n) {
+    uint32_t v = 1;
+    for (unsigned i = 0; i < n; ++i) {
+        v <<= 1;
+        if (v & 0x10000) v ^= 0x18005;
+    }
+    return v;
+}
+constexpr uint64_t reflect64(uint64_t v) {
+    uint64_t r = 0;
+    for (int i = 0; i < 64; ++i)
+        if (v & (uint64_t(1) << i)) r |= uint64_t(1) << (63 - i);
+    return r;
+}
+// Folding a 128-bit lane forward by D bits multiplies its polynomial-high qword (the low
+// qword in reflected memory order) by x^(D+64) and the other by x^D. PCLMUL of reflected
+// operands yields the product times x, hence the -1.
+constexpr uint64_t crc16_fold_const(unsigned d) { return reflect64(crc16_xpow_mod(d - 1)); }
+
+} // namespace detail
+
+// 256-entry table, one lookup per byte.
+inline uint16_t crc16_table(const uint8_t* data, std::size_t len, uint16_t crc = 0xFFFF) {
+    const auto& t0 = detail::crc16_slices[0];
+    for (std::size_t i = 0; i < len; ++i)
+        crc = static_cast<uint16_t>((crc >> 8) ^ t0[(crc ^ data[i]) & 0xFF]);
+    return crc;
+}
+
+// Slice-by-8: eight independent lookups per 8 input bytes.
+inline uint16_t crc16_slice8(const uint8_t* data, std::size_t len, uint16_t crc = 0xFFFF) {
+    const auto& t = detail::crc16_slices;
+    while (len >= 8) {
+        crc = static_cast<uint16_t>(
+            t[7][(data[0] ^ crc) & 0xFF] ^ t[6][(data[1] ^ (crc >> 8)) & 0xFF] ^
+            t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]]);
+        data += 8;
+        len -= 8;
+    }
+    return crc16_table(data, len, crc);
+}
+
+#ifdef ACT_CRC16_HAVE_CLMUL
+namespace detail {
+__attribute__((target("pclmul,sse2")))
+inline __m128i clmul_fold(__m128i x, __m128i k, __m128i next) {
+    const __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+    const __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), next);
+}
+__attribute__((target("sse2")))
+inline __m128i clmul_load(const uint8_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+} // namespace detail
+
+// Carry-less multiply folding: four 128-bit lanes folded 64 bytes at a time, then merged
+// into one lane whose 16 bytes are reduced with the table (CRC_0 of the folded lane equals
+// CRC_0 of the prefix it stands for). Only call when crc16_clmul_supported().
+__attribute__((target("pclmul,sse2")))
+inline uint16_t crc16_clmul(const uint8_t* data, std::size_t len, uint16_t crc = 0xFFFF) {
+    if (len < 64) return crc16_slice8(data, len, crc);
+    const __m128i k128 = _mm_set_epi64x(static_cast<long long>(detail::crc16_fold_const(128)),
+                                        static_cast<long long>(detail::crc16_fold_const(192)));
+    const __m128i k512 = _mm_set_epi64x(static_cast<long long>(detail::crc16_fold_const(512)),
+                                        static_cast<long long>(detail::crc16_fold_const(576)));
+
+    // Seeding: xoring the register into the first two bytes turns it into a CRC_0 problem.
+    __m128i x0 = _mm_xor_si128(detail::clmul_load(data), _mm_cvtsi32_si128(crc));
+    __m128i x1 = detail::clmul_load(data + 16);
+    __m128i x2 = detail::clmul_load(data + 32);
+    __m128i x3 = detail::clmul_load(data + 48);
+    data += 64;
+    len -= 64;
+    while (len >= 64) {
+        x0 = detail::clmul_fold(x0, k512, detail::clmul_load(data));
+        x1 = detail::clmul_fold(x1, k512, detail::clmul_load(data + 16));
+        x2 = detail::clmul_fold(x2, k512, detail::clmul_load(data + 32));
+        x3 = detail::clmul_fold(x3, k512, detail::clmul_load(data + 48));
+        data += 64;
+        len -= 64;
+    }
+    __m128i x = detail::clmul_fold(x0, k128, x1);
+    x = detail::clmul_fold(x, k128, x2);
+    x = detail::clmul_fold(x, k128, x3);
+    while (len >= 16) {
+        x = detail::clmul_fold(x, k128, detail::clmul_load(data));
+        data += 16;
+        len -= 16;
+    }
+    alignas(16) uint8_t lane[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lane), x);
+    return crc16_slice8(data, len, crc16_slice8(lane, sizeof(lane), 0));
+}
+
+inline bool crc16_clmul_supported() {
+    static const bool ok = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse2");
+    return ok;
+}
+#else
+inline uint16_t crc16_clmul(const uint8_t* data, std::size_t len, uint16_t crc = 0xFFFF) {
+    return crc16_slice8(data, len, crc);
+}
+inline bool crc16_clmul_supported() { return false; }
+#endif
+
+enum class crc16_engine { bitwise, table, slice8, clmul };
+
+inline const char* crc16_engine_name(crc16_engine e) {
+    switch (e) {
+    case crc16_engine::bitwise: return "bitwise";
+    case crc16_engine::table: return "table";
+    case crc16_engine::slice8: return "slice8";
+    case crc16_engine::clmul: return "clmul";
+    }
+    return "?";
+}
+
+inline bool crc16_engine_supported(crc16_engine e) {
+    return e != crc16_engine::clmul || crc16_clmul_supported();
+}
+
+inline uint16_t crc16_with(crc16_engine e, const uint8_t* data, std::size_t len, uint16_t crc = 0xFFFF) {
+    switch (e) {
+    case crc16_engine::bitwise: return crc16(data, len, crc);
+    case crc16_engine::table: return crc16_table(data, len, crc);
+    case crc16_engine::slice8: return crc16_slice8(data, len, crc);
+    case crc16_engine::clmul: return crc16_clmul(data, len, crc);
+    }
+    return crc16(data, len, crc);
+}
+
+// Engine used for long buffers, chosen once per process.
+inline crc16_engine crc16_best_engine() {
+    static const crc16_engine best = crc16_clmul_supported() ? crc16_engine::clmul : crc16_engine::slice8;
+    return best;
+}
+
+// Most frames on this bus are 8..41 bytes, where slice-by-8 beats the CLMUL setup cost;
+// multi-register reads and capture buffers go to the engine picked for this CPU.
+inline uint16_t crc16_fast(const uint8_t* data, std::size_t len, uint16_t crc = 0xFFFF) {
+    if (len < 64) return crc16_slice8(data, len, crc);
+    return crc16_with(crc16_best_engine(), data, len, crc);
+}
+
+// Complete frame of N bytes including the trailing [CRC-Lo][CRC-Hi].
+template <std::size_t N>
+struct frame {
+    static_assert(N >= 4, "a Modbus RTU frame has at least addr, func and CRC");
+    std::array<uint8_t, N> bytes{};
+
+    constexpr const uint8_t* data() const { return bytes.data(); }
+    constexpr std::size_t size() const { return N; }
+    constexpr uint8_t operator[](std::size_t i) const { return bytes[i]; }
+
+    constexpr uint16_t crc() const {
+        return static_cast<uint16_t>(bytes[N - 2] | (bytes[N - 1] << 8));
+    }
+    constexpr bool crc_ok() const { return crc16(bytes.data(), N - 2) == crc(); }
+
+    // Recompute the CRC after the body changed.
+    constexpr void seal() {
+        const uint16_t c = crc16(bytes.data(), N - 2);
+        bytes[N - 2] = static_cast<uint8_t>(c & 0xFF);
+        bytes[N - 1] = static_cast<uint8_t>((c >> 8) & 0xFF);
+    }
+
+    // Patch a runtime field (big-endian) and reseal; the rest of the frame stays as built.
+    constexpr void set_u8(std::size_t off, uint8_t v) {
+        bytes[off] = v;
+        seal();
+    }
+    constexpr void set_u16(std::size_t off, uint16_t v) {
+        bytes[off] = static_cast<uint8_t>((v >> 8) & 0xFF);
+        bytes[off + 1] = static_cast<uint8_t>(v & 0xFF);
+        seal();
+    }
+    constexpr void set_u16_pair(std::size_t off, uint16_t a, std::size_t off2, uint16_t b) {
+        bytes[off] = static_cast<uint8_t>((a >> 8) & 0xFF);
+        bytes[off + 1] = static_cast<uint8_t>(a & 0xFF);
+        bytes[off2] = static_cast<uint8_t>((b >> 8) & 0xFF);
+        bytes[off2 + 1] = static_cast<uint8_t>(b & 0xFF);
+        seal();
+    }
+
+    constexpr bool operator==(const frame& o) const {
+        for (std::size_t i = 0; i < N; ++i)
+            if (bytes[i] != o.bytes[i]) return false;
+        return true;
+    }
+    constexpr bool operator!=(const frame& o) const { return !(*this == o); }
+};
+
+// Non-owning view so frames of different lengths can share one sequence table.
+struct frame_view {
+    const uint8_t* ptr = nullptr;
+    std::size_t len = 0;
+
+    constexpr frame_view() = default;
+    template <std::size_t N>
+    constexpr frame_view(const frame<N>& f) : ptr(f.bytes.data()), len(N) {}
+
+    constexpr const uint8_t* data() const { return ptr; }
+    constexpr std::size_t size() const { return len; }
+};
+
+// [slave][function][addrHi][addrLo][payload...][CRC-Lo][CRC-Hi]
+template <std::size_t P>
+constexpr frame<P + 6> make_frame(uint8_t slave, uint8_t function, uint16_t address,
+                                  const std::array<uint8_t, P>& payload) {
+    frame<P + 6> f{};
+    f.bytes[0] = slave;
+    f.bytes[1] = function;
+    f.bytes[2] = static_cast<uint8_t>((address >> 8) & 0xFF);
+    f.bytes[3] = static_cast<uint8_t>(address & 0xFF);
+    for (std::size_t i = 0; i < P; ++i) f.bytes[4 + i] = payload[i];
+    f.seal();
+    return f;
+}
+
+// 0x03 Read Holding Registers.
+constexpr frame<8> read_holding(uint8_t slave, uint16_t address, uint16_t quantity) {
+    return make_frame(slave, 0x03, address, std::array<uint8_t, 2>{
+        static_cast<uint8_t>((quantity >> 8) & 0xFF), static_cast<uint8_t>(quantity & 0xFF)});
+}
+
+// 0x05 Write Single Coil (ON = FF 00, OFF = 00 00).
+constexpr frame<8> write_coil(uint8_t slave, uint16_t coil, bool on) {
+    return make_frame(slave, 0x05, coil, std::array<uint8_t, 2>{
+        static_cast<uint8_t>(on ? 0xFF : 0x00), 0x00});
+}
+
+// 0x0F Write Multiple Coils; B packed coil bytes.
+template <std::size_t B>
+constexpr frame<B + 9> write_coils(uint8_t slave, uint16_t coil, uint16_t quantity,
+                                   const std::array<uint8_t, B>& packed) {
+    std::array<uint8_t, B + 3> p{};
+    p[0] = static_cast<uint8_t>((quantity >> 8) & 0xFF);
+    p[1] = static_cast<uint8_t>(quantity & 0xFF);
+    p[2] = static_cast<uint8_t>(B);
+    for (std::size_t i = 0; i < B; ++i) p[3 + i] = packed[i];
+    return make_frame(slave, 0x0F, coil, p);
+}
+
+// 0x10 Write Multiple Registers; R big-endian register values.
+// Register k of the data block sits at frame offset write_register_offset(k).
+template <std::size_t R>
+constexpr frame<2 * R + 9> write_registers(uint8_t slave, uint16_t address,
+                                           const std::array<uint16_t, R>& regs) {
+    std::array<uint8_t, 2 * R + 3> p{};
+    p[0] = static_cast<uint8_t>((R >> 8) & 0xFF);
+    p[1] = static_cast<uint8_t>(R & 0xFF);
+    p[2] = static_cast<uint8_t>(2 * R);
+    for (std::size_t i = 0; i < R; ++i) {
+        p[3 + 2 * i] = static_cast<uint8_t>((regs[i] >> 8) & 0xFF);
+        p[4 + 2 * i] = static_cast<uint8_t>(regs[i] & 0xFF);
+    }
+    return make_frame(slave, 0x10, address, p);
+}
+constexpr std::size_t write_register_offset(std::size_t reg) { return 7 + 2 * reg; }
+
+// Wrap a captured frame (CRC included). Used in a constant expression, a wrong CRC
+// does not compile; at runtime it throws.
+template <std::size_t N>
+constexpr frame<N> checked(const uint8_t (&raw)[N]) {
+    frame<N> f{};
+    for (std::size_t i = 0; i < N; ++i) f.bytes[i] = raw[i];
+    if (!f.crc_ok()) throw std::logic_error("modbus::checked: CRC mismatch in captured frame");
+    return f;
+}
+
+// Point a sealed frame at another slave address and reseal its CRC.
+inline void readdress(uint8_t* f, std::size_t len, uint8_t slave) {
+    if (len < 4 || f[0] == slave) return;
+    f[0] = slave;
+    const uint16_t c = crc16_fast(f, len - 2);
+    f[len - 2] = static_cast<uint8_t>(c & 0xFF);
+    f[len - 1] = static_cast<uint8_t>((c >> 8) & 0xFF);
+}
+
+// Incremental parser for RTU replies (controller -> PC). Feed it whatever the port
+// returned, in any chunking; next() hands back each complete, CRC-checked frame,
+// exception replies included. The length of a reply follows from its function code:
+// byte count + 5 for reads (0x01..0x04), 8 for the write echoes (0x05, 0x06, 0x0F,
+// 0x10), 5 for exceptions. Bytes that cannot start a reply, and candidates whose CRC
+// fails, are skipped until a valid frame lines up again; a complete valid frame further
+// on also wins over an incomplete candidate at the front (noise that looks like the
+// start of a long read reply). The counters tell how often each happened.
+class rtu_parser {
+public:
+    static constexpr std::size_t k_capacity = 512;
+
+    struct stats {
+        uint64_t frames = 0;     // CRC-valid frames returned by next()
+        uint64_t exceptions = 0; // ... of which exception replies
+        uint64_t crc_errors = 0; // complete candidates at the front with a bad CRC
+        uint64_t discarded = 0;  // bytes skipped to resynchronize
+        uint64_t resyncs = 0;    // times alignment was lost (a run of skipped bytes counts once)
+    };
+
+    void feed(const uint8_t* p, std::size_t n) {
+        consume();
+        while (n > 0) {
+            if (end_ == k_capacity) {
+                if (begin_ == 0) drop(1); // full of undecodable bytes: oldest goes
+                compact();
+            }
+            const std::size_t k = std::min(n, k_capacity - end_);
+            std::copy(p, p + k, buf_ + end_);
+            end_ += k;
+            p += k;
+            n -= k;
+        }
+    }
+
+    // Next complete frame, or 0 when none is complete yet. *frame stays valid until the
+    // following feed() or next().
+    std::size_t next(const uint8_t** frame) {
+        consume();
+        while (begin_ < end_) {
+            const std::size_t need = frame_length(buf_ + begin_, end_ - begin_);
+            if (need == k_invalid) {
+                drop(1);
+                continue;
+            }
+            if (need != 0 && begin_ + need <= end_) {
+                if (crc16_fast(buf_ + begin_, need) == 0) return take(begin_, need, frame);
+                ++stats_.crc_errors;
+                drop(1);
+                continue;
+            }
+            break; // front candidate incomplete
+        }
+        // Look past an incomplete front candidate for a frame that is already whole
+        for (std::size_t off = begin_ + 1; off + 5 <= end_; ++off) {
+            const std::size_t need = frame_length(buf_ + off, end_ - off);
+            if (need == k_invalid || need == 0 || off + need > end_) continue;
+            if (crc16_fast(buf_ + off, need) != 0) continue;
+            drop(off - begin_);
+            return take(begin_, need, frame);
+        }
+        return 0;
+    }
+
+    // Bytes held back as an incomplete frame.
+    std::size_t pending() const { return end_ - begin_ - taken_; }
+    const uint8_t* pending_data() const { return buf_ + begin_ + taken_; }
+
+    // Give up on the incomplete frame (silence ended it, or a new request makes it stale).
+    void discard_pending() {
+        consume();
+        if (begin_ < end_) drop(end_ - begin_);
+        begin_ = end_ = 0;
+    }
+
+    const stats& counters() const { return stats_; }
+
+    // Total reply length from its first bytes: 0 if more bytes are needed to tell,
+    // k_invalid if p cannot be the start of a reply.
+    static constexpr std::size_t k_invalid = static_cast<std::size_t>(-1);
+    static std::size_t frame_length(const uint8_t* p, std::size_t n) {
+        if (n < 1) return 0;
+        if (p[0] == 0 || p[0] > 247) return k_invalid; // broadcast gets no reply; 248+ reserved
+        if (n < 2) return 0;
+        const uint8_t func = p[1];
+        const uint8_t base = func & 0x7F;
+        const bool known = base == 0x01 || base == 0x02 || base == 0x03 || base == 0x04 ||
+                           base == 0x05 || base == 0x06 || base == 0x0F || base == 0x10;
+        if (!known) return k_invalid;
+        if (func & 0x80) return 5;
+        if (base <= 0x04) {
+            if (n < 3) return 0;
+            const uint8_t count = p[2];
+            if (count == 0 || ((base == 0x03 || base == 0x04) && (count & 1))) return k_invalid;
+            return 5 + static_cast<std::size_t>(count);
+        }
+        return 8;
+    }
+
+private:
+    std::size_t take(std::size_t off, std::size_t len, const uint8_t** frame) {
+        ++stats_.frames;
+        if (buf_[off + 1] & 0x80) ++stats_.exceptions;
+        skipping_ = false;
+        *frame = buf_ + off;
+        taken_ = len;
+        return len;
+    }
+    // Release the frame handed out by the last next()
+    void consume() {
+        begin_ += taken_;
+        taken_ = 0;
+        if (begin_ == end_) begin_ = end_ = 0;
+    }
+    void drop(std::size_t n) {
+        begin_ += n;
+        stats_.discarded += n;
+        if (!skipping_) ++stats_.resyncs;
+        skipping_ = true;
+    }
+    void compact() {
+        std::copy(buf_ + begin_, buf_ + end_, buf_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+
+    uint8_t buf_[k_capacity];
+    std::size_t begin_ = 0;
+    std::size_t end_ = 0;
+    std::size_t taken_ = 0;
+    bool skipping_ = false;
+    stats stats_;
+};
+
+} // namespace modbus
+
+class act_controller {
+    friend class act_controller_pool;
+
+public:
+    // Outcome of one request/reply exchange.
+    enum class reply_status { ok, timeout, exception, crc_error, io_error };
+
+    static const char* reply_status_name(reply_status s) {
+        switch (s) {
+        case reply_status::ok: return "ok";
+        case reply_status::timeout: return "timeout";
+        case reply_status::exception: return "exception";
+        case reply_status::crc_error: return "crc_error";
+        case reply_status::io_error: return "io_error";
+        }
+        return "?";
+    }
+
+    // The API call a bus transaction was made for, as tagged in wire captures and keyed
+    // in the latency metrics. init is one step of the connect() init sequence (metrics
+    // keep one histogram per step). The values are stored in capture files: append only.
+    enum class wire_op : uint8_t { other, init, move_relative, move_absolute, position, status,
+                                   trajectory, telemetry, reset, line_rate, probe };
+    static constexpr std::size_t k_wire_ops = 11;
+    static constexpr std::size_t k_init_steps = 20; // frames in the connect() init sequence
+
+    static const char* wire_op_name(wire_op op) {
+        switch (op) {
+        case wire_op::other: return "other";
+        case wire_op::init: return "init";
+        case wire_op::move_relative: return "move_relative";
+        case wire_op::move_absolute: return "move_absolute";
+        case wire_op::position: return "position";
+        case wire_op::status: return "status";
+        case wire_op::trajectory: return "trajectory";
+        case wire_op::telemetry: return "telemetry";
+        case wire_op::reset: return "reset";
+        case wire_op::line_rate: return "line_rate";
+        case wire_op::probe: return "probe";
+        }
+        return "?";
+    }
+
+    struct reply_result {
+        std::size_t len = 0;
+        reply_status status = reply_status::timeout;
+        uint8_t exception_code = 0;
+    };
+
+    // reply_status as the error_code of the async API (ok is success). Not connected is
+    // reported as asio::error::not_connected.
+    static const asio::error_category& reply_category() {
+        struct category : asio::error_category {
+            const char* name() const noexcept override { return "act_controller.reply"; }
+            std::string message(int v) const override {
+                return reply_status_name(static_cast<reply_status>(v));
+            }
+        };
+        static const category c;
+        return c;
+    }
+
+    static asio::error_code make_error_code(reply_status s) {
+        if (s == reply_status::ok) return asio::error_code();
+        return asio::error_code(static_cast<int>(s), reply_category());
+    }
+
+    // What an async_* call returns for a given completion token: void for callbacks,
+    // std::future for use_future, an awaitable for use_awaitable.
+    template <typename CompletionToken, typename Signature>
+    using async_result_t = typename asio::async_result<std::decay_t<CompletionToken>, Signature>::return_type;
+
+    // One telemetry reading of the position register.
+    struct position_sample {
+        int position = 0;                               // external units (as get_current_position())
+        int32_t raw = 0;                                // device units (x100), sign-extended
+        std::chrono::steady_clock::time_point timestamp; // when the reply arrived
+        uint64_t sequence = 0;                          // 1, 2, 3... per published sample
+        uint16_t status = 0;                            // status word read with the position
+    };
+
+    // Masks over the status word (register 0x9000) for the controller's motion flags.
+    // The word's bit layout is not decoded yet (doc section 1.3), so every mask defaults
+    // to 0 = unknown; with in_position unknown, blocking moves keep the tolerance check.
+    struct status_bits {
+        uint16_t busy = 0;
+        uint16_t in_position = 0;
+        uint16_t alarm = 0;
+    };
+
+    // Registers 0x9000..0x9001, the two words of the position block actually used.
+    struct status_snapshot {
+        int position = 0;                                // external units
+        int16_t raw = 0;                                 // device units (x100)
+        uint16_t status = 0;                             // register 0x9000
+        bool flags_known = false;                        // an in_position mask is configured
+        bool busy = false;
+        bool in_position = false;
+        bool alarm = false;
+        std::chrono::steady_clock::time_point timestamp; // when the reply arrived; epoch if the read failed
+    };
+
+    // The whole 16-register block at 0x9000 (the connect probe's reply).
+    struct status_block {
+        std::array<uint16_t, 16> words{}; // words[i] = register 0x9000 + i
+        status_snapshot status;           // words 0..1, decoded as read_status() does
+        uint16_t word(uint16_t reg) const { return words.at(static_cast<std::size_t>(reg - 0x9000)); }
+    };
+
+    // Result of the last connect() init sequence; failed_step indexes the init frames
+    // (see doc section 9) of the first step without a good reply, -1 when every step was
+    // acknowledged.
+    struct init_report {
+        bool ok = false;
+        int failed_step = -1;
+        int unacked = 0; // steps without a good reply (strict init stops at the first)
+        reply_status status = reply_status::ok;
+        uint8_t exception_code = 0;
+        std::chrono::microseconds elapsed{0};
+    };
+
+    // Predicts how long a move takes, from command issue to arrival, as
+    // overhead + slope * distance / speed (distance in external units, speed byte),
+    // fitted by least squares over observed moves. Older moves decay, so the fit follows
+    // load and mechanical changes. Thread-safe.
+    class motion_estimator {
+    public:
+        static constexpr std::size_t k_min_samples = 2;
+
+        void observe(int distance, int speed, std::chrono::microseconds settle) {
+            const double x = feature(distance, speed);
+            const double y = static_cast<double>(settle.count()) / 1000.0;
+            std::lock_guard<std::mutex> lk(mutex_);
+            w_ = w_ * k_decay + 1.0;
+            sx_ = sx_ * k_decay + x;
+            sy_ = sy_ * k_decay + y;
+            sxx_ = sxx_ * k_decay + x * x;
+            sxy_ = sxy_ * k_decay + x * y;
+            syy_ = syy_ * k_decay + y * y;
+            ++samples_;
+            late_scale_ = std::max(1.0, late_scale_ / 2);
+        }
+
+        // The first read after waking was already in position, so the arrival time is
+        // unknown; wake earlier next time until a move is bracketed again.
+        void note_late() {
+            std::lock_guard<std::mutex> lk(mutex_);
+            late_scale_ = std::min(8.0, late_scale_ * 2);
+        }
+
+        // Empty until k_min_samples moves have been observed.
+        std::optional<std::chrono::microseconds> predict(int distance, int speed) const {
+            std::lock_guard<std::mutex> lk(mutex_);
+            double a = 0, b = 0;
+            if (!fit(a, b)) return std::nullopt;
+            const double ms = std::max(0.0, a + b * feature(distance, speed));
+            return std::chrono::microseconds(std::llround(ms * 1000.0));
+        }
+
+        // How long before a predicted arrival to start polling: twice the fit's residual
+        // deviation, widened after late wake-ups, never less than one dense poll.
+        std::chrono::microseconds margin() const {
+            std::lock_guard<std::mutex> lk(mutex_);
+            double a = 0, b = 0, ms = 0;
+            if (fit(a, b) && w_ > 0) {
+                const double sse = syy_ - a * sy_ - b * sxy_;
+                ms = 2.0 * std::sqrt(std::max(0.0, sse / w_));
+            }
+            const double floor_ms = static_cast<double>(k_dense_poll.count());
+            return std::chrono::microseconds(std::llround(std::max(ms, floor_ms) * late_scale_ * 1000.0));
+        }
+
+        bool calibrated() const {
+            std::lock_guard<std::mutex> lk(mutex_);
+            double a = 0, b = 0;
+            return fit(a, b);
+        }
+        std::size_t samples() const {
+            std::lock_guard<std::mutex> lk(mutex_);
+            return samples_;
+        }
+        // Fitted model terms: fixed ms per move, and ms per (unit / speed byte)
+        double overhead_ms() const {
+            std::lock_guard<std::mutex> lk(mutex_);
+            double a = 0, b = 0;
+            return fit(a, b) ? a : 0.0;
+        }
+        double slope_ms() const {
+            std::lock_guard<std::mutex> lk(mutex_);
+            double a = 0, b = 0;
+            return fit(a, b) ? b : 0.0;
+        }
+
+        void reset() {
+            std::lock_guard<std::mutex> lk(mutex_);
+            w_ = sx_ = sy_ = sxx_ = sxy_ = syy_ = 0;
+            samples_ = 0;
+            late_scale_ = 1.0;
+        }
+
+    private:
+        static constexpr double k_decay = 0.97;
+
+        static double feature(int distance, int speed) {
+            return std::abs(distance) / static_cast<double>(std::max(1, speed));
+        }
+
+        bool fit(double& a, double& b) const {
+            if (samples_ < k_min_samples || w_ <= 0) return false;
+            const double den = w_ * sxx_ - sx_ * sx_;
+            b = den > 1e-9 * w_ * w_ ? (w_ * sxy_ - sx_ * sy_) / den : 0.0;
+            // Moves never get faster with distance; all-equal x also lands here
+            if (b < 0) b = 0;
+            a = (sy_ - b * sx_) / w_;
+            return true;
+        }
+
+        mutable std::mutex mutex_;
+        double w_ = 0, sx_ = 0, sy_ = 0, sxx_ = 0, sxy_ = 0, syy_ = 0;
+        std::size_t samples_ = 0;
+        double late_scale_ = 1.0;
+    };
+
+    // Poll period once a blocking wait is inside the predicted arrival window
+    static constexpr std::chrono::milliseconds k_dense_poll{20};
+    // Poll period while the estimator is not calibrated (the historical blind polling)
+    static constexpr std::chrono::milliseconds k_blind_poll{120};
+
+    // How the last blocking move's wait went. Times are from command issue; actual is the
+    // midpoint between the last out-of-tolerance and the first in-tolerance reading (or
+    // that reading alone when the first one was already in position).
+    struct settle_report {
+        bool arrived = false;
+        bool calibrated = false;                 // predicted came from the estimator
+        int distance = 0;                        // -1: start position unknown, not predicted
+        int speed = 0;
+        std::chrono::microseconds predicted{0};
+        std::chrono::microseconds actual{0};
+        int polls = 0;                           // position reads (or fresh telemetry samples)
+        bool by_flag = false;                    // ended on the in-position flag, not the tolerance
+        bool alarm = false;                      // gave up on the alarm flag
+    };
+
+    // How absolute moves are sent. fast: speed and position in one write
+    // (0x0411..0x0413), then the start pulse, each frame sent as soon as the previous one
+    // is acknowledged. legacy: the captured vendor sequence, six frames 100 ms apart.
+    // legacy is the default until fast is confirmed on hardware; a controller that
+    // refuses a fast frame is switched back to legacy.
+    enum class absolute_mode { fast, legacy };
+
+    // How every request/reply is bounded. The first attempt waits for the wire time plus
+    // rtt_factor times the p99 of this arm's measured turnaround (reply time minus wire
+    // time), clamped to [min_turnaround, max_turnaround]. Retries, and first attempts
+    // before k_rtt_min_samples replies have been timed, allow the full max_turnaround.
+    // Timeouts and CRC errors are retried up to `retries` times, except the relative move
+    // trigger, which would start a second move. A dead controller therefore costs
+    // (retries + 1) bounded waits.
+    struct transaction_policy {
+        int retries = 1;
+        double rtt_factor = 3.0;
+        std::chrono::milliseconds min_turnaround{10};
+        std::chrono::milliseconds max_turnaround{250};
+    };
+
+    struct transaction_stats {
+        std::size_t samples = 0;                 // turnaround samples in the window
+        std::chrono::microseconds p50{0};
+        std::chrono::microseconds p99{0};
+        std::chrono::microseconds max{0};
+        std::chrono::microseconds allowance{0};  // turnaround allowed to the next first attempt
+        uint64_t transactions = 0;
+        uint64_t retries = 0;
+        uint64_t timeouts = 0;                   // attempts that ran out of time
+    };
+
+    // The rate of the captured vendor software
+    static constexpr unsigned k_default_baud = 38400;
+
+    // Serial line settings used by connect() (8N1 at `baud`). The drive's rate is one of
+    // its stored parameters, so it is not always the one expected: with auto_detect (off
+    // by default, each rate costs a probe timeout), a connect() that finds no controller
+    // at `baud` probes again at each other candidate rate, and keeps the rate that
+    // answered in `baud`. Only the requested port is re-probed when connect() names one.
+    struct line_settings {
+        unsigned baud = k_default_baud;
+        bool auto_detect = false;
+        std::vector<unsigned> candidates{38400, 115200, 57600, 19200, 9600, 230400};
+        bool low_latency = false; // Linux: tune the port and USB adapter for reply latency
+    };
+
+    // What line_settings::low_latency could apply to the open port. Each knob is tried on
+    // its own; one the port does not support (a pty, a non-USB UART) reports false / -1.
+    struct low_latency_report {
+        bool requested = false;
+        bool async_low_latency = false; // TIOCSSERIAL ASYNC_LOW_LATENCY set
+        bool vmin_vtime = false;        // VMIN 1 / VTIME 0 set
+        int latency_timer_ms = -1;      // USB adapter latency timer now, -1 if it has none
+        int latency_timer_was_ms = -1;  // ... and before (restored when the port closes)
+    };
+
+    // Real-time settings for a thread (Linux). priority > 0 selects SCHED_FIFO at that
+    // priority (1..99, needs CAP_SYS_NICE or an rtprio limit); cpus pins the thread
+    // (empty: no pinning); lock_memory calls mlockall(MCL_CURRENT | MCL_FUTURE) for the
+    // whole process; timer_slack_ns >= 0 sets the thread's timer slack (default 50 us),
+    // which otherwise delays every timed wake-up by up to that much.
+    struct realtime_options {
+        int priority = 50;
+        std::vector<int> cpus;
+        bool lock_memory = true;
+        long timer_slack_ns = 1;
+    };
+
+    // Which realtime_options took effect; failed knobs are false with their errno.
+    struct realtime_report {
+        bool sched_fifo = false;
+        bool affinity = false;
+        bool memory_locked = false;
+        bool timer_slack = false;
+        int sched_errno = 0;
+        int affinity_errno = 0;
+        int lock_errno = 0;
+        int slack_errno = 0;
+    };
+
+    // How late timed wake-ups ran: intended vs actual time, in a log2 histogram of
+    // microseconds. Lock-free, so the I/O thread and caller threads can both record.
+    class jitter_recorder {
+    public:
+        static constexpr std::size_t k_buckets = 24; // bucket i: below 2^i us; the last one takes the rest
+
+        struct snapshot {
+            uint64_t samples = 0;
+            std::chrono::microseconds mean{0};
+            std::chrono::microseconds p99{0}; // upper edge of the bucket holding the 99th percentile
+            std::chrono::microseconds max{0};
+            std::array<uint64_t, k_buckets> buckets{};
+        };
+
+        void record(std::chrono::steady_clock::time_point intended, std::chrono::steady_clock::time_point actual) {
+            const long long us = std::max<long long>(
+                0, std::chrono::duration_cast<std::chrono::microseconds>(actual - intended).count());
+            std::size_t b = 0;
+            while (b + 1 < k_buckets && us >= (1LL << b)) ++b;
+            buckets_[b].fetch_add(1, std::memory_order_relaxed);
+            samples_.fetch_add(1, std::memory_order_relaxed);
+            total_us_.fetch_add(static_cast<uint64_t>(us), std::memory_order_relaxed);
+            uint64_t prev = max_us_.load(std::memory_order_relaxed);
+            while (static_cast<uint64_t>(us) > prev &&
+                   !max_us_.compare_exchange_weak(prev, static_cast<uint64_t>(us), std::memory_order_relaxed)) {}
+        }
+
+        snapshot get() const {
+            snapshot out;
+            out.samples = samples_.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < k_buckets; ++i) out.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+            out.max = std::chrono::microseconds(max_us_.load(std::memory_order_relaxed));
+            if (out.samples == 0) return out;
+            out.mean = std::chrono::microseconds(total_us_.load(std::memory_order_relaxed) / out.samples);
+            uint64_t seen = 0;
+            for (std::size_t i = 0; i < k_buckets; ++i) {
+                seen += out.buckets[i];
+                if (seen * 100 >= out.samples * 99) {
+                    out.p99 = std::min(out.max, std::chrono::microseconds(1LL << i));
+                    break;
+                }
+            }
+            return out;
+        }
+
+        void reset() {
+            for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+            samples_.store(0, std::memory_order_relaxed);
+            total_us_.store(0, std::memory_order_relaxed);
+            max_us_.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, k_buckets> buckets_{};
+        std::atomic<uint64_t> samples_{0};
+        std::atomic<uint64_t> total_us_{0};
+        std::atomic<uint64_t> max_us_{0};
+    };
+
+    // HDR-style latency histogram in microseconds: exact below 16 us, then 16 linear
+    // sub-buckets per power of two, so a reported value is within 1/16 of what was
+    // recorded up to 2^32 us (about 71 minutes; larger values share the top bucket).
+    // Recording is a few relaxed atomic adds and readers never block, from any thread.
+    class latency_histogram {
+    public:
+        static constexpr int k_sub_bits = 4;
+        static constexpr std::size_t k_sub = std::size_t(1) << k_sub_bits;
+        static constexpr int k_max_exp = 32;
+        static constexpr std::size_t k_buckets = (k_max_exp - k_sub_bits + 1) * k_sub;
+
+        struct summary {
+            uint64_t samples = 0;
+            std::chrono::microseconds total{0};
+            std::chrono::microseconds mean{0};
+            std::chrono::microseconds p50{0}; // percentiles: top of the bucket, capped at max
+            std::chrono::microseconds p90{0};
+            std::chrono::microseconds p99{0};
+            std::chrono::microseconds p999{0};
+            std::chrono::microseconds max{0};
+        };
+
+        void record(std::chrono::microseconds d) {
+            const uint64_t us = static_cast<uint64_t>(std::max<long long>(0, d.count()));
+            counts_[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+            total_us_.fetch_add(us, std::memory_order_relaxed);
+            uint64_t prev = max_us_.load(std::memory_order_relaxed);
+            while (us > prev && !max_us_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {}
+        }
+
+        // Raw state, kept by a reader that wants a summary of the samples recorded after it
+        // (since()) without resetting the histogram under other readers.
+        struct counts {
+            std::array<uint64_t, k_buckets> buckets{};
+            uint64_t total_us = 0;
+        };
+
+        summary get() const { return since(counts{}); }
+
+        counts mark() const {
+            counts out;
+            for (std::size_t i = 0; i < k_buckets; ++i) out.buckets[i] = counts_[i].load(std::memory_order_relaxed);
+            out.total_us = total_us_.load(std::memory_order_relaxed);
+            return out;
+        }
+
+        // Summary of the samples recorded after `base` was marked. The maximum is not kept
+        // per sample, so it is capped at the top of the highest bucket that grew.
+        summary since(const counts& base) const {
+            summary out;
+            std::array<uint64_t, k_buckets> c;
+            uint64_t n = 0;
+            std::size_t top = 0;
+            for (std::size_t i = 0; i < k_buckets; ++i) {
+                n += (c[i] = counts_[i].load(std::memory_order_relaxed) - base.buckets[i]);
+                if (c[i] != 0) top = i;
+            }
+            out.samples = n;
+            out.max = std::chrono::microseconds(max_us_.load(std::memory_order_relaxed));
+            out.total = std::chrono::microseconds(total_us_.load(std::memory_order_relaxed) - base.total_us);
+            if (n == 0) {
+                out.max = std::chrono::microseconds(0);
+                return out;
+            }
+            if (top < k_buckets - 1) out.max = std::min(out.max, std::chrono::microseconds(bucket_high(top)));
+            out.mean = out.total / static_cast<long long>(n);
+            auto at = [&](double q) {
+                const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(n))));
+                uint64_t seen = 0;
+                for (std::size_t i = 0; i < k_buckets; ++i) {
+                    seen += c[i];
+                    if (seen >= rank) return std::min(out.max, std::chrono::microseconds(bucket_high(i)));
+                }
+                return out.max;
+            };
+            out.p50 = at(0.5);
+            out.p90 = at(0.9);
+            out.p99 = at(0.99);
+            out.p999 = at(0.999);
+            return out;
+        }
+
+        void reset() {
+            for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+            total_us_.store(0, std::memory_order_relaxed);
+            max_us_.store(0, std::memory_order_relaxed);
+        }
+
+        static std::size_t bucket_of(uint64_t us) {
+            if (us < k_sub) return static_cast<std::size_t>(us);
+            int m = 0; // floor(log2(us))
+            while ((us >> (m + 1)) != 0) ++m;
+            if (m >= k_max_exp) return k_buckets - 1;
+            return static_cast<std::size_t>(m - k_sub_bits + 1) * k_sub + static_cast<std::size_t>((us >> (m - k_sub_bits)) - k_sub);
+        }
+
+        // Largest value that lands in bucket b.
+        static uint64_t bucket_high(std::size_t b) {
+            if (b < k_sub) return b;
+            const int shift = static_cast<int>(b / k_sub) - 1;
+            const uint64_t s = k_sub + b % k_sub;
+            return ((s + 1) << shift) - 1;
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, k_buckets> counts_{};
+        std::atomic<uint64_t> total_us_{0};
+        std::atomic<uint64_t> max_us_{0};
+    };
+
+    // What a recorded wake-up was for: command pacing (frame gaps, trajectory dwells) or
+    // a position poll (telemetry, trajectory and blocking-move polls).
+    enum class wake_kind { command, poll };
+
+private:
+    // The last k_size controller turnaround times, for the adaptive reply deadline.
+    // I/O thread only.
+    class rtt_window {
+    public:
+        static constexpr std::size_t k_size = 128;
+
+        void add(std::chrono::microseconds t) {
+            const long long us = std::max<long long>(0, t.count());
+            samples_[next_] = static_cast<uint32_t>(std::min<long long>(us, UINT32_MAX));
+            next_ = (next_ + 1) % k_size;
+            if (count_ < k_size) ++count_;
+        }
+
+        std::size_t count() const { return count_; }
+
+        // Nearest-rank percentile, q in (0, 1]; 0 when empty.
+        std::chrono::microseconds percentile(double q) const {
+            if (count_ == 0) return std::chrono::microseconds(0);
+            std::array<uint32_t, k_size> s;
+            std::copy(samples_.begin(), samples_.begin() + count_, s.begin());
+            const double rank = std::ceil(q * static_cast<double>(count_));
+            const std::size_t k = std::min(count_ - 1, static_cast<std::size_t>(std::max(1.0, rank)) - 1);
+            std::nth_element(s.begin(), s.begin() + k, s.begin() + count_);
+            return std::chrono::microseconds(s[k]);
+        }
+
+    private:
+        std::array<uint32_t, k_size> samples_{};
+        std::size_t next_ = 0;
+        std::size_t count_ = 0;
+    };
+
+    // Free lists of fixed-size blocks (64..1024 bytes) for queued callbacks and asio
+    // operation state. A block freed by one command is reused by the next, so once the
+    // first few commands have warmed it up the command path makes no heap allocations.
+    // Blocks are never given back; larger requests go straight to operator new.
+    class block_pool {
+    public:
+        static void* allocate(std::size_t n) {
+            const std::size_t cls = class_of(n);
+            if (cls == k_classes) return ::operator new(n);
+            bucket& b = buckets()[cls];
+            {
+                std::lock_guard<std::mutex> lk(b.m);
+                if (node* p = b.head) {
+                    b.head = p->next;
+                    return p;
+                }
+            }
+            return ::operator new(k_min_block << cls);
+        }
+
+        static void deallocate(void* p, std::size_t n) {
+            const std::size_t cls = class_of(n);
+            if (cls == k_classes) {
+                ::operator delete(p);
+                return;
+            }
+            bucket& b = buckets()[cls];
+            std::lock_guard<std::mutex> lk(b.m);
+            b.head = new (p) node{b.head};
+        }
+
+    private:
+        static constexpr std::size_t k_min_block = 64;
+        static constexpr std::size_t k_classes = 5;
+        struct node { node* next; };
+        struct bucket {
+            std::mutex m;
+            node* head = nullptr;
+        };
+
+        static std::size_t class_of(std::size_t n) {
+            std::size_t cls = 0;
+            while (cls < k_classes && (k_min_block << cls) < n) ++cls;
+            return cls;
+        }
+        static bucket* buckets() {
+            static bucket b[k_classes];
+            return b;
+        }
+    };
+
+    // Standard allocator over block_pool, the associated allocator of pooled handlers.
+    template <typename T>
+    struct pool_allocator {
+        using value_type = T;
+        pool_allocator() noexcept = default;
+        template <typename U> pool_allocator(const pool_allocator<U>&) noexcept {}
+        T* allocate(std::size_t n) { return static_cast<T*>(block_pool::allocate(n * sizeof(T))); }
+        void deallocate(T* p, std::size_t n) noexcept { block_pool::deallocate(p, n * sizeof(T)); }
+        template <typename U> bool operator==(const pool_allocator<U>&) const noexcept { return true; }
+        template <typename U> bool operator!=(const pool_allocator<U>&) const noexcept { return false; }
+    };
+
+    // An internal asio handler whose operation state (post, timer wait, read, write) comes
+    // from block_pool instead of the heap; asio picks the allocator up through
+    // associated_allocator.
+    template <typename Handler>
+    struct pooled_handler {
+        using allocator_type = pool_allocator<void>;
+        allocator_type get_allocator() const noexcept { return allocator_type(); }
+        template <typename... Args>
+        void operator()(Args&&... args) { h(std::forward<Args>(args)...); }
+        Handler h;
+    };
+
+    template <typename Handler>
+    static pooled_handler<std::decay_t<Handler>> pooled(Handler&& h) {
+        return pooled_handler<std::decay_t<Handler>>{std::forward<Handler>(h)};
+    }
+
+public:
+    // Move-only type-erased callable. Completion handlers (futures, coroutines) are often
+    // move-only, which rules out std::function for queued work. The callable lives in a
+    // block_pool block.
+    template <typename Sig> class unique_callback;
+    template <typename R, typename... Args>
+    class unique_callback<R(Args...)> {
+        struct base {
+            virtual R call(Args... args) = 0;
+            virtual void destroy() = 0;
+        protected:
+            ~base() = default;
+        };
+        template <typename F>
+        struct impl final : base {
+            explicit impl(F&& fn) : f(std::move(fn)) {}
+            R call(Args... args) override { return f(std::forward<Args>(args)...); }
+            void destroy() override {
+                this->~impl();
+                block_pool::deallocate(this, sizeof(impl));
+            }
+            F f;
+        };
+        base* fn_ = nullptr;
+
+    public:
+        unique_callback() = default;
+        template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, unique_callback>::value>>
+        unique_callback(F f) {
+            static_assert(alignof(impl<F>) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned callable");
+            void* mem = block_pool::allocate(sizeof(impl<F>));
+            try {
+                fn_ = new (mem) impl<F>(std::move(f));
+            } catch (...) {
+                block_pool::deallocate(mem, sizeof(impl<F>));
+                throw;
+            }
+        }
+        unique_callback(unique_callback&& o) noexcept : fn_(o.fn_) { o.fn_ = nullptr; }
+        unique_callback& operator=(unique_callback&& o) noexcept {
+            if (this != &o) {
+                reset();
+                fn_ = o.fn_;
+                o.fn_ = nullptr;
+            }
+            return *this;
+        }
+        unique_callback(const unique_callback&) = delete;
+        unique_callback& operator=(const unique_callback&) = delete;
+        ~unique_callback() { reset(); }
+
+        explicit operator bool() const { return fn_ != nullptr; }
+        R operator()(Args... args) { return fn_->call(std::forward<Args>(args)...); }
+
+    private:
+        void reset() {
+            if (fn_) fn_->destroy();
+            fn_ = nullptr;
+        }
+    };
+
+    using bus_job = unique_callback<void()>;
+
+private:
+    // Synchronous wrappers block on this until their handler ran on the I/O thread.
+    struct sync_waiter {
+        std::mutex m;
+        std::condition_variable cv;
+        bool done = false;
+        // Notify under the lock: the waiter may destroy *this as soon as it wakes.
+        void signal() {
+            std::lock_guard<std::mutex> lk(m);
+            done = true;
+            cv.notify_one();
+        }
+        void wait() {
+            std::unique_lock<std::mutex> lk(m);
+            cv.wait(lk, [this] { return done; });
+        }
+    };
+
+    // Frames of one fire-and-forget command, copied into the bus job that sends them.
+    struct command_batch {
+        std::array<std::array<uint8_t, 48>, 6> frames{};
+        std::array<std::size_t, 6> lens{};
+        std::size_t count = 0;
+        std::chrono::milliseconds pause{100}; // between frames, as in the vendor captures
+        wire_op op = wire_op::other;
+
+        void add(const uint8_t* p, std::size_t n) {
+            std::copy(p, p + n, frames[count].begin());
+            lens[count++] = n;
+        }
+        template <typename Frame>
+        void add(const Frame& f) { add(f.data(), f.size()); }
+    };
+
+public:
+    // Byte stream under a serial_bus: a serial port, or anything that behaves like one.
+    // Every call comes from the bus's I/O thread, and completions must be delivered there
+    // (posted, never invoked inline).
+    class transport {
+    public:
+        using io_handler = unique_callback<void(asio::error_code, std::size_t)>;
+
+        virtual ~transport() = default;
+        // Throws asio::system_error when the device cannot be opened.
+        virtual low_latency_report open(const std::string& name, unsigned baud, bool low_latency) = 0;
+        virtual void close() = 0;
+        virtual bool is_open() const = 0;
+        virtual void set_baud(unsigned baud) = 0;
+        // Drop bytes already received but not yet read (stale acks, noise). Returns how
+        // many, where the platform can tell.
+        virtual std::size_t discard_input() = 0;
+        // Write all n bytes.
+        virtual void async_write(const uint8_t* p, std::size_t n, io_handler done) = 0;
+        // Read at least one byte, at most n.
+        virtual void async_read_some(uint8_t* p, std::size_t n, io_handler done) = 0;
+        // Complete a pending read with operation_aborted.
+        virtual void cancel() = 0;
+        // A real serial device: connect() may scan other ports for the controller.
+        virtual bool is_serial() const { return false; }
+    };
+
+    // The serial port backend.
+    class serial_transport final : public transport {
+    public:
+        explicit serial_transport(asio::io_context& io) : port_(io) {}
+
+        low_latency_report open(const std::string& name, unsigned baud, bool low_latency) override {
+            port_.open(name);
+            configure(port_, baud);
+            if (!low_latency) return low_latency_report{};
+            const low_latency_report rep = tune_low_latency(port_, name, latency_timer_path_);
+            latency_timer_was_ = rep.latency_timer_was_ms;
+            return rep;
+        }
+
+        void close() override {
+            if (port_.is_open()) {
+                asio::error_code ec;
+                port_.close(ec);
+            }
+            // The adapter's latency timer is system-wide state: put it back
+            if (!latency_timer_path_.empty()) write_sysfs(latency_timer_path_, latency_timer_was_);
+            latency_timer_path_.clear();
+        }
+
+        bool is_open() const override { return port_.is_open(); }
+        void set_baud(unsigned baud) override { port_.set_option(asio::serial_port_base::baud_rate(baud)); }
+
+        std::size_t discard_input() override {
+#ifdef _WIN32
+            DWORD errors = 0;
+            COMSTAT st{};
+            const std::size_t n = ::ClearCommError(port_.native_handle(), &errors, &st) ? st.cbInQue : 0;
+            ::PurgeComm(port_.native_handle(), PURGE_RXCLEAR);
+#else
+            int queued = 0;
+            const std::size_t n = ::ioctl(port_.native_handle(), FIONREAD, &queued) == 0 ? static_cast<std::size_t>(queued) : 0;
+            ::tcflush(port_.native_handle(), TCIFLUSH);
+#endif
+            return n;
+        }
+
+        void async_write(const uint8_t* p, std::size_t n, io_handler done) override {
+            asio::async_write(port_, asio::buffer(p, n),
+                pooled([d = std::move(done)](const asio::error_code& ec, std::size_t k) mutable { d(ec, k); }));
+        }
+
+        void async_read_some(uint8_t* p, std::size_t n, io_handler done) override {
+            port_.async_read_some(asio::buffer(p, n),
+                pooled([d = std::move(done)](const asio::error_code& ec, std::size_t k) mutable { d(ec, k); }));
+        }
+
+        void cancel() override {
+            asio::error_code ignored;
+            port_.cancel(ignored);
+        }
+
+        bool is_serial() const override { return true; }
+
+    private:
+        asio::serial_port port_;
+        std::string latency_timer_path_; // sysfs file we lowered, empty if none
+        int latency_timer_was_ = -1;
+    };
+
+    // In-process stand-in for the drive: the register map act_controller uses, with
+    // linear kinematics and a configurable reply latency. Thread-safe, so a test can
+    // change parameters or read the true position while an arm drives it.
+    //   0x9000        status word: busy_bit while moving, in_position_bit otherwise
+    //   0x9001        position (device units, signed)
+    //   0x9102..      relative move block: 0x9103 speed, 0x9104:0x9105 signed delta
+    //   0x9100        relative move trigger (any write starts the move)
+    //   0x0411..0x0413 absolute speed, 0, position
+    //   coil 0x001A   OFF -> ON edge starts the absolute move; other coils are stored
+    // Other holding registers read back what was written (0 initially). Unsupported
+    // functions get exception 01, bad quantities exception 03.
+    class simulated_actuator {
+    public:
+        struct params {
+            uint8_t slave = k_slave_addr;
+            std::chrono::microseconds reply_latency{0}; // request received -> reply sent
+            bool wire_delay = false;                    // also hold the reply for its wire time
+            double units_per_second = 100.0;            // travel rate at speed byte 10; linear in speed
+            std::chrono::microseconds move_overhead{0}; // trigger -> motion start
+            uint16_t busy_bit = 0x0001;
+            uint16_t in_position_bit = 0x0002;
+            int16_t start_raw = 0;
+        };
+
+        simulated_actuator() : simulated_actuator(params()) {}
+        explicit simulated_actuator(const params& p) : p_(p), from_raw_(p.start_raw), to_raw_(p.start_raw) {}
+
+        void set_params(const params& p) {
+            std::lock_guard<std::mutex> lk(mutex_);
+            p_ = p;
+        }
+        params get_params() const {
+            std::lock_guard<std::mutex> lk(mutex_);
+            return p_;
+        }
+        // A silent drive gets every request and answers none.
+        void set_silent(bool silent) { silent_ = silent; }
+
+        int32_t raw_position(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const {
+            std::lock_guard<std::mutex> lk(mutex_);
+            return raw_at(now);
+        }
+        int position() const { return scale_position(static_cast<int16_t>(raw_position())); }
+        bool moving(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const {
+            std::lock_guard<std::mutex> lk(mutex_);
+            return now < arrive_;
+        }
+        uint64_t requests() const { return requests_; }
+        uint64_t moves() const { return moves_; }
+
+        // One request frame in (CRC-checked); the reply, CRC included, goes to out.
+        // Returns the reply length, 0 for no reply, and the delay before it is sent.
+        std::size_t handle(const uint8_t* req, std::size_t len, uint8_t* out,
+                           std::chrono::steady_clock::time_point now, std::chrono::microseconds& delay) {
+            ++requests_;
+            std::lock_guard<std::mutex> lk(mutex_);
+            delay = p_.reply_latency;
+            if (silent_ || len < 4 || req[0] != p_.slave || modbus::crc16_fast(req, len) != 0) return 0;
+            const uint8_t func = req[1];
+            const uint16_t addr = be16(req + 2);
+            std::size_t n = 0;
+            out[n++] = req[0];
+            out[n++] = func;
+            auto fail = [&](uint8_t code) {
+                out[1] = static_cast<uint8_t>(func | 0x80);
+                out[2] = code;
+                return std::size_t(3);
+            };
+            if (func == 0x03 || func == 0x04) {
+                const uint16_t qty = be16(req + 4);
+                if (len != 8 || qty == 0 || qty > 125) n = fail(0x03);
+                else {
+                    out[n++] = static_cast<uint8_t>(2 * qty);
+                    for (uint16_t i = 0; i < qty; ++i) {
+                        const uint16_t v = read_register(static_cast<uint16_t>(addr + i), now);
+                        out[n++] = static_cast<uint8_t>(v >> 8);
+                        out[n++] = static_cast<uint8_t>(v & 0xFF);
+                    }
+                }
+            } else if (func == 0x05 && len == 8) {
+                write_coil(addr, req[4] == 0xFF, now);
+                std::copy(req + 2, req + 6, out + 2);
+                n = 6;
+            } else if (func == 0x06 && len == 8) {
+                write_register(addr, be16(req + 4), now);
+                std::copy(req + 2, req + 6, out + 2);
+                n = 6;
+            } else if (func == 0x0F && len >= 9 && len == 9u + req[6]) {
+                const uint16_t qty = be16(req + 4);
+                for (uint16_t i = 0; i < qty && i / 8 < req[6]; ++i)
+                    write_coil(static_cast<uint16_t>(addr + i), (req[7 + i / 8] >> (i % 8)) & 1, now);
+                std::copy(req + 2, req + 6, out + 2);
+                n = 6;
+            } else if (func == 0x10 && len >= 9 && len == 9u + req[6]) {
+                const uint16_t qty = be16(req + 4);
+                if (qty == 0 || 2u * qty != req[6]) n = fail(0x03);
+                else {
+                    for (uint16_t i = 0; i < qty; ++i)
+                        write_register(static_cast<uint16_t>(addr + i), be16(req + 7 + 2 * i), now);
+                    std::copy(req + 2, req + 6, out + 2);
+                    n = 6;
+                }
+            } else {
+                n = fail(0x01);
+            }
+            const uint16_t crc = modbus::crc16_fast(out, n);
+            out[n++] = static_cast<uint8_t>(crc & 0xFF);
+            out[n++] = static_cast<uint8_t>(crc >> 8);
+            return n;
+        }
+
+        // Extra reply delay for wire_delay at the given line rate.
+        std::chrono::microseconds wire_delay(std::size_t n, unsigned baud) const {
+            std::lock_guard<std::mutex> lk(mutex_);
+            return p_.wire_delay ? wire_time(n, baud) : std::chrono::microseconds(0);
+        }
+
+    private:
+        int32_t raw_at(std::chrono::steady_clock::time_point now) const {
+            if (now >= arrive_) return to_raw_;
+            if (now <= depart_) return from_raw_;
+            const double f = std::chrono::duration<double>(now - depart_).count() /
+                             std::chrono::duration<double>(arrive_ - depart_).count();
+            return from_raw_ + static_cast<int32_t>(std::lround((to_raw_ - from_raw_) * f));
+        }
+
+        uint16_t read_register(uint16_t reg, std::chrono::steady_clock::time_point now) const {
+            if (reg == 0x9000) return now < arrive_ ? p_.busy_bit : p_.in_position_bit;
+            if (reg == 0x9001) return static_cast<uint16_t>(static_cast<int16_t>(raw_at(now)));
+            return regs_[reg];
+        }
+
+        void write_register(uint16_t reg, uint16_t v, std::chrono::steady_clock::time_point now) {
+            regs_[reg] = v;
+            if (reg == 0x9100) {
+                const int32_t delta = static_cast<int32_t>((static_cast<uint32_t>(regs_[0x9104]) << 16) | regs_[0x9105]);
+                start_move(raw_at(now) + delta, regs_[0x9103], now);
+            }
+        }
+
+        void write_coil(uint16_t coil, bool on, std::chrono::steady_clock::time_point now) {
+            const bool was = coils_[coil];
+            coils_[coil] = on;
+            if (coil == 0x001A && on && !was) start_move(static_cast<int16_t>(regs_[0x0413]), regs_[0x0411], now);
+        }
+
+        void start_move(int32_t target, uint16_t speed, std::chrono::steady_clock::time_point now) {
+            target = std::clamp<int32_t>(target, INT16_MIN, INT16_MAX);
+            from_raw_ = raw_at(now);
+            to_raw_ = target;
+            const double units = std::abs(to_raw_ - from_raw_) / 100.0;
+            const double rate = p_.units_per_second * std::max<uint16_t>(1, speed) / 10.0;
+            depart_ = now + p_.move_overhead;
+            arrive_ = depart_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(rate > 0 ? units / rate : 0.0));
+            ++moves_;
+        }
+
+        mutable std::mutex mutex_;
+        params p_;
+        std::array<uint16_t, 65536> regs_{};
+        std::array<bool, 65536> coils_{};
+        int32_t from_raw_;
+        int32_t to_raw_;
+        std::chrono::steady_clock::time_point depart_;
+        std::chrono::steady_clock::time_point arrive_;
+        std::atomic<bool> silent_{false};
+        std::atomic<uint64_t> requests_{0};
+        std::atomic<uint64_t> moves_{0};
+    };
+
+    // Base of the in-process transports: written requests are answered from a short queue
+    // of replies, each delivered once its time has come through an asio timer on the
+    // bus's io_context, so the whole serial_bus path (parser, deadlines, retries) runs
+    // unchanged. Subclasses decide what a request gets in respond().
+    class scripted_transport : public transport {
+    public:
+        explicit scripted_transport(asio::io_context& io) : io_(io), timer_(io) {}
+
+        low_latency_report open(const std::string&, unsigned baud, bool) override {
+            open_ = true;
+            baud_ = baud;
+            return low_latency_report{};
+        }
+        void close() override {
+            open_ = false;
+            count_ = 0;
+            cancel();
+        }
+        bool is_open() const override { return open_; }
+        void set_baud(unsigned baud) override { baud_ = baud; }
+
+        std::size_t discard_input() override {
+            const auto now = std::chrono::steady_clock::now();
+            std::size_t n = 0;
+            while (count_ > 0 && at(0).ready <= now) {
+                n += at(0).len - at(0).off;
+                pop();
+            }
+            return n;
+        }
+
+        void async_write(const uint8_t* p, std::size_t n, io_handler done) override {
+            if (!open_) {
+                asio::post(io_, pooled([d = std::move(done)]() mutable { d(asio::error::bad_descriptor, 0); }));
+                return;
+            }
+            respond(p, n, std::chrono::steady_clock::now());
+            asio::post(io_, pooled([d = std::move(done), n]() mutable { d(asio::error_code(), n); }));
+            if (read_) arm();
+        }
+
+        void async_read_some(uint8_t* p, std::size_t n, io_handler done) override {
+            read_buf_ = p;
+            read_cap_ = n;
+            read_ = std::move(done);
+            arm();
+        }
+
+        void cancel() override {
+            timer_.cancel();
+            if (!read_) return;
+            auto d = std::move(read_);
+            asio::post(io_, pooled([d = std::move(d)]() mutable { d(asio::error::operation_aborted, 0); }));
+        }
+
+    protected:
+        static constexpr std::size_t k_reply_max = 260;
+
+        // Queue the reply to the request just written.
+        virtual void respond(const uint8_t* p, std::size_t n, std::chrono::steady_clock::time_point now) = 0;
+
+        // Bytes to hand to the reader at `ready`; dropped when the queue is full.
+        void queue_reply(const uint8_t* p, std::size_t n, std::chrono::steady_clock::time_point ready) {
+            if (count_ == k_queue || n == 0) return;
+            reply& r = at(count_++);
+            r.len = std::min(n, k_reply_max);
+            std::copy(p, p + r.len, r.data);
+            r.off = 0;
+            r.ready = ready;
+        }
+
+        unsigned line_baud() const { return baud_; }
+
+    private:
+        static constexpr std::size_t k_queue = 16;
+        struct reply {
+            std::chrono::steady_clock::time_point ready;
+            std::size_t len = 0;
+            std::size_t off = 0;
+            uint8_t data[k_reply_max];
+        };
+
+        reply& at(std::size_t i) { return queue_[(head_ + i) % k_queue]; }
+        void pop() {
+            head_ = (head_ + 1) % k_queue;
+            --count_;
+        }
+
+        // Complete the pending read from the first reply once it is due.
+        void arm() {
+            if (!read_ || count_ == 0) return;
+            const auto ready = at(0).ready;
+            if (ready <= std::chrono::steady_clock::now()) {
+                deliver();
+                return;
+            }
+            timer_.expires_at(ready);
+            timer_.async_wait(pooled([this](const asio::error_code& ec) {
+                if (!ec) deliver();
+            }));
+        }
+
+        void deliver() {
+            if (!read_ || count_ == 0) return;
+            reply& r = at(0);
+            const std::size_t k = std::min(read_cap_, r.len - r.off);
+            std::copy(r.data + r.off, r.data + r.off + k, read_buf_);
+            r.off += k;
+            if (r.off == r.len) pop();
+            auto d = std::move(read_);
+            asio::post(io_, pooled([d = std::move(d), k]() mutable { d(asio::error_code(), k); }));
+        }
+
+        asio::io_context& io_;
+        asio::steady_timer timer_;
+        bool open_ = false;
+        unsigned baud_ = k_default_baud;
+        std::array<reply, k_queue> queue_{};
+        std::size_t head_ = 0;
+        std::size_t count_ = 0;
+        uint8_t* read_buf_ = nullptr;
+        std::size_t read_cap_ = 0;
+        io_handler read_;
+    };
+
+    // Transport onto a simulated_actuator: each request is answered after the actuator's
+    // delay, at memory speed.
+    class sim_transport final : public scripted_transport {
+    public:
+        sim_transport(asio::io_context& io, std::shared_ptr<simulated_actuator> sim)
+            : scripted_transport(io), sim_(std::move(sim)) {}
+
+    private:
+        void respond(const uint8_t* p, std::size_t n, std::chrono::steady_clock::time_point now) override {
+            uint8_t out[k_reply_max];
+            std::chrono::microseconds delay{0};
+            const std::size_t len = sim_->handle(p, n, out, now, delay);
+            queue_reply(out, len, now + delay + sim_->wire_delay(len, line_baud()));
+        }
+
+        std::shared_ptr<simulated_actuator> sim_;
+    };
+
+    // Wire capture: every frame a serial_bus writes, every chunk its port returns and the
+    // outcome of each transaction, with monotonic nanosecond timestamps, appended to a
+    // memory-mapped file (plain buffered writes on Windows). The file is sized to its
+    // capacity up front, so recording is a copy into the mapping; records that no longer
+    // fit are counted as dropped instead of growing it. Layout, all little-endian:
+    //   header (32 bytes): "ACTWIRE1", u32 version, u32 line rate, u64 bytes used
+    //                      (header included, updated after every record), u64 reserved
+    //   record (12 + len): u64 ns since start, u16 len, u8 kind | crc << 2, u8 wire_op,
+    //                      payload
+    // Version 2 tags the connect() probe as wire_op::probe. Version 1 had a single
+    // connect op (1) for the probe and the init frames; the reader maps it to init.
+    // A tx payload is the frame as sent, an rx payload the bytes one read returned (the
+    // port's own chunking, so a replay goes through the parser the same way), a result
+    // payload one reply_status byte. An rx chunk's crc says whether the parser completed
+    // a valid frame (ok) or rejected a candidate (bad) while consuming it.
+    class wire_capture {
+    public:
+        enum class kind : uint8_t { tx, rx, result };
+        enum class crc_state : uint8_t { none, ok, bad };
+
+        static constexpr std::size_t k_default_capacity = 64u << 20;
+        static constexpr std::size_t k_header = 32;
+        static constexpr std::size_t k_record_header = 12;
+        static constexpr uint32_t k_version = 2;
+
+        struct stats {
+            uint64_t records = 0;
+            uint64_t bytes = 0;   // file size so far, header included
+            uint64_t dropped = 0; // records that did not fit
+        };
+
+        wire_capture() = default;
+        ~wire_capture() { close(); }
+        wire_capture(const wire_capture&) = delete;
+        wire_capture& operator=(const wire_capture&) = delete;
+
+        // Create (truncate) path with room for `capacity` bytes. False when the file
+        // cannot be created or mapped.
+        bool open(const std::string& path, std::size_t capacity, unsigned baud) {
+            close();
+            capacity = std::max(capacity, k_header);
+#ifndef _WIN32
+            fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd_ < 0) return false;
+            void* m = MAP_FAILED;
+            if (::ftruncate(fd_, static_cast<off_t>(capacity)) == 0)
+                m = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if (m == MAP_FAILED) {
+                ::close(fd_);
+                fd_ = -1;
+                return false;
+            }
+            base_ = static_cast<uint8_t*>(m);
+#else
+            file_ = std::fopen(path.c_str(), "wb");
+            if (!file_) return false;
+            buf_.resize(capacity);
+            base_ = buf_.data();
+#endif
+            cap_ = capacity;
+            std::fill(base_, base_ + k_header, uint8_t(0));
+            std::copy(k_magic, k_magic + 8, base_);
+            put(base_ + 8, k_version, 4);
+            put(base_ + 12, baud, 4);
+            used_ = k_header;
+            put(base_ + 16, used_, 8);
+            stats_ = stats{};
+            stats_.bytes = used_;
+            t0_ = std::chrono::steady_clock::now();
+            return true;
+        }
+
+        bool is_open() const { return base_ != nullptr; }
+
+        // Unmap and cut the file to the bytes used.
+        void close() {
+            if (!base_) return;
+#ifndef _WIN32
+            ::munmap(base_, cap_);
+            (void)!::ftruncate(fd_, static_cast<off_t>(used_));
+            ::close(fd_);
+            fd_ = -1;
+#else
+            std::fwrite(base_, 1, used_, file_);
+            std::fclose(file_);
+            file_ = nullptr;
+            std::vector<uint8_t>().swap(buf_);
+#endif
+            base_ = nullptr;
+        }
+
+        void record(kind k, crc_state crc, wire_op op, const uint8_t* p, std::size_t n,
+                    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now()) {
+            if (!base_) return;
+            if (n > 0xFFFF || used_ + k_record_header + n > cap_) {
+                ++stats_.dropped;
+                return;
+            }
+            uint8_t* r = base_ + used_;
+            put(r, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t - t0_).count()), 8);
+            put(r + 8, n, 2);
+            r[10] = static_cast<uint8_t>(static_cast<uint8_t>(k) | (static_cast<uint8_t>(crc) << 2));
+            r[11] = static_cast<uint8_t>(op);
+            std::copy(p, p + n, r + k_record_header);
+            used_ += k_record_header + n;
+            put(base_ + 16, used_, 8);
+            ++stats_.records;
+            stats_.bytes = used_;
+        }
+
+        const stats& counters() const { return stats_; }
+
+        // A capture file read back whole.
+        class reader {
+        public:
+            struct record {
+                std::chrono::nanoseconds t{0};
+                kind dir = kind::tx;
+                crc_state crc = crc_state::none;
+                wire_op op = wire_op::other;
+                std::vector<uint8_t> data;
+            };
+
+            // False if the file is missing, not a capture or from a newer version; records
+            // end at the last complete one, so a capture cut short by a crash still loads.
+            bool load(const std::string& path) {
+                records_.clear();
+                std::ifstream in(path, std::ios::binary);
+                if (!in) return false;
+                std::vector<uint8_t> f((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                if (f.size() < k_header || !std::equal(k_magic, k_magic + 8, f.begin())) return false;
+                version_ = static_cast<uint32_t>(get(f.data() + 8, 4));
+                if (version_ == 0 || version_ > k_version) return false;
+                baud_ = static_cast<unsigned>(get(f.data() + 12, 4));
+                const std::size_t used = static_cast<std::size_t>(std::min<uint64_t>(get(f.data() + 16, 8), f.size()));
+                std::size_t off = k_header;
+                while (off + k_record_header <= used) {
+                    const uint8_t* r = f.data() + off;
+                    const std::size_t n = static_cast<std::size_t>(get(r + 8, 2));
+                    if (off + k_record_header + n > used) break;
+                    record rec;
+                    rec.t = std::chrono::nanoseconds(static_cast<int64_t>(get(r, 8)));
+                    rec.dir = static_cast<kind>(r[10] & 0x03);
+                    rec.crc = static_cast<crc_state>((r[10] >> 2) & 0x03);
+                    rec.op = static_cast<wire_op>(r[11]); // version 1's connect (1) is init
+                    rec.data.assign(r + k_record_header, r + k_record_header + n);
+                    records_.push_back(std::move(rec));
+                    off += k_record_header + n;
+                }
+                return true;
+            }
+
+            const std::vector<record>& records() const { return records_; }
+            unsigned baud() const { return baud_; }
+            uint32_t version() const { return version_; }
+
+        private:
+            std::vector<record> records_;
+            unsigned baud_ = 0;
+            uint32_t version_ = 0;
+        };
+
+    private:
+        static constexpr uint8_t k_magic[8] = {'A', 'C', 'T', 'W', 'I', 'R', 'E', '1'};
+
+        static void put(uint8_t* p, uint64_t v, int n) {
+            for (int i = 0; i < n; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+        }
+        static uint64_t get(const uint8_t* p, int n) {
+            uint64_t v = 0;
+            for (int i = 0; i < n; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+            return v;
+        }
+
+        uint8_t* base_ = nullptr;
+        std::size_t cap_ = 0;
+        std::size_t used_ = 0;
+#ifndef _WIN32
+        int fd_ = -1;
+#else
+        std::FILE* file_ = nullptr;
+        std::vector<uint8_t> buf_;
+#endif
+        std::chrono::steady_clock::time_point t0_;
+        stats stats_;
+    };
+
+    // Transport that plays a capture back: the k-th request written gets the rx chunks
+    // that followed the capture's k-th tx frame, each after its recorded delay divided by
+    // `speed` (0 delivers at once), whatever the request says.
+    class replay_transport final : public scripted_transport {
+    public:
+        replay_transport(asio::io_context& io, std::shared_ptr<const wire_capture::reader> cap, double speed)
+            : scripted_transport(io), cap_(std::move(cap)), speed_(speed) {}
+
+    private:
+        void respond(const uint8_t*, std::size_t, std::chrono::steady_clock::time_point now) override {
+            const auto& recs = cap_->records();
+            while (next_ < recs.size() && recs[next_].dir != wire_capture::kind::tx) ++next_;
+            if (next_ == recs.size()) return;
+            const auto& tx = recs[next_++];
+            for (; next_ < recs.size() && recs[next_].dir != wire_capture::kind::tx; ++next_) {
+                const auto& r = recs[next_];
+                if (r.dir != wire_capture::kind::rx) continue;
+                const double ns = speed_ > 0 ? static_cast<double>((r.t - tx.t).count()) / speed_ : 0.0;
+                queue_reply(r.data.data(), r.data.size(),
+                            now + std::chrono::nanoseconds(static_cast<int64_t>(std::max(0.0, ns))));
+            }
+        }
+
+        std::shared_ptr<const wire_capture::reader> cap_;
+        double speed_;
+        std::size_t next_ = 0;
+    };
+
+    // Builds the transport of a standalone controller's bus on its io_context.
+    using transport_factory = std::function<std::unique_ptr<transport>(asio::io_context&)>;
+
+    // Factory for a controller driving `sim` instead of a serial port.
+    static transport_factory simulated(std::shared_ptr<simulated_actuator> sim) {
+        return [sim](asio::io_context& io) { return std::make_unique<sim_transport>(io, sim); };
+    }
+
+    // Factory for a controller fed from a capture (see replay_transport).
+    static transport_factory replayed(std::shared_ptr<const wire_capture::reader> cap, double speed = 1.0) {
+        return [cap, speed](asio::io_context& io) { return std::make_unique<replay_transport>(io, cap, speed); };
+    }
+
+    // One serial line and the transaction in progress on it. Every controller on the
+    // line (one per slave address on a shared RS-485 bus) is a client with its own
+    // command queue: a client runs one command at a time, and the commands' bus slots
+    // (one transaction or one frame write each) are handed out round-robin across the
+    // clients that are waiting, so a long command on one arm cannot starve another.
+    // Everything runs on the io_context passed in, which must be driven by one thread.
+    class serial_bus {
+    public:
+        explicit serial_bus(asio::io_context& io)
+            : serial_bus(io, std::make_unique<serial_transport>(io)) {}
+        serial_bus(asio::io_context& io, std::unique_ptr<transport> t)
+            : io_(io), port_(std::move(t)), deadline_timer_(io), gap_timer_(io) {}
+
+        serial_bus(const serial_bus&) = delete;
+        serial_bus& operator=(const serial_bus&) = delete;
+
+        asio::io_context& io() { return io_; }
+        bool is_open() const { return port_->is_open(); }
+        bool is_serial() const { return port_->is_serial(); }
+        const std::string& port_name() const { return name_; }
+
+        // I/O thread, or before anything was submitted.
+        void open(const std::string& name, unsigned baud = k_default_baud, bool low_latency = false) {
+            latency_ = port_->open(name, baud, low_latency);
+            name_ = name;
+            baud_ = baud;
+        }
+
+        // I/O thread: switch the open port to another rate.
+        void set_baud(unsigned baud) {
+            port_->set_baud(baud);
+            baud_ = baud;
+        }
+
+        // Any thread; the rate the port was last configured at.
+        unsigned baud() const { return baud_; }
+
+        void close() {
+            port_->close();
+            latency_ = low_latency_report{};
+            name_.clear();
+        }
+
+        // I/O thread.
+        const low_latency_report& latency_report() const { return latency_; }
+
+        // Any thread. Client ids are handed out in order; the queue itself is created on
+        // the I/O thread the first time it is touched.
+        std::size_t add_client() { return next_client_++; }
+
+        // Any thread: queue a command. It runs on the I/O thread after the client's
+        // previous command called finish_command().
+        void submit(std::size_t client, bus_job command) {
+            asio::post(io_, pooled([this, client, c = std::move(command)]() mutable {
+                at(client).commands.push(std::move(c));
+                pump_commands(client);
+            }));
+        }
+
+        // I/O thread: the client's current command is done; start its next one.
+        void finish_command(std::size_t client) {
+            at(client).running = false;
+            asio::post(io_, pooled([this, client] { pump_commands(client); }));
+        }
+
+        // I/O thread, from inside a command: run slot once the bus is free and it is this
+        // client's turn. The slot must end with release().
+        void acquire(std::size_t client, bus_job slot) {
+            at(client).slot = std::move(slot);
+            pump_slots();
+        }
+
+        // Posted, so a run of slots that finish immediately does not recurse.
+        void release() {
+            busy_ = false;
+            asio::post(io_, pooled([this] { pump_slots(); }));
+        }
+
+        // Bus slot: throw away whatever is already sitting in the OS buffer (nothing sent
+        // before the request can be its reply), write req re-addressed to slave, then read
+        // until the parser yields the frame that answers it, CRC-checked, into rx.
+        void transact(uint8_t slave, wire_op op, const uint8_t* req, std::size_t len, uint8_t* rx, std::size_t cap,
+                      std::chrono::microseconds timeout, unique_callback<void(reply_result)> done) {
+            txn_begin(timeout, std::move(done));
+            txn_.slave = slave;
+            txn_.op = op;
+            txn_.func = req[1];
+            txn_.out = rx;
+            txn_.cap = cap;
+            if (!port_->is_open() || len > sizeof(txn_.tx)) {
+                txn_finish(reply_status::io_error);
+                return;
+            }
+            std::copy(req, req + len, txn_.tx);
+            modbus::readdress(txn_.tx, len, slave);
+            discard_input();
+            rx_.discard_pending();
+            txn_.crc_errors = rx_.counters().crc_errors;
+            if (capture_) capture_->record(wire_capture::kind::tx, wire_capture::crc_state::ok, op, txn_.tx, len);
+            const uint64_t gen = txn_.gen;
+            port_->async_write(txn_.tx, len, [this, gen](asio::error_code ec, std::size_t) {
+                if (gen != txn_.gen || txn_.finished) return;
+                if (ec) {
+                    txn_finish(reply_status::io_error);
+                    return;
+                }
+                start_reply_chunk(gen);
+            });
+        }
+
+        // Receive-side counters: the parser's, plus valid frames that answered no pending
+        // request (late acks, other masters, replies to a timed-out request).
+        struct rx_stats {
+            modbus::rtu_parser::stats parser;
+            uint64_t unmatched = 0;
+        };
+
+        // I/O thread.
+        rx_stats stats() const { return rx_stats{rx_.counters(), unmatched_}; }
+
+        // Line counters for metrics, readable from any thread without waiting on the I/O
+        // thread. drained_bytes counts stale input flushed before a request plus bytes
+        // the parser skipped.
+        struct line_metrics {
+            uint64_t drained_bytes = 0;
+            uint64_t crc_errors = 0;
+            uint64_t resyncs = 0;
+            uint64_t unmatched = 0;
+        };
+        line_metrics metrics() const {
+            line_metrics m;
+            m.drained_bytes = flushed_.load(std::memory_order_relaxed) + parser_discarded_.load(std::memory_order_relaxed);
+            m.crc_errors = parser_crc_errors_.load(std::memory_order_relaxed);
+            m.resyncs = parser_resyncs_.load(std::memory_order_relaxed);
+            m.unmatched = unmatched_pub_.load(std::memory_order_relaxed);
+            return m;
+        }
+
+        // I/O thread: record this line's traffic into cap (nullptr stops recording).
+        // Returns the capture it replaces.
+        std::unique_ptr<wire_capture> set_capture(std::unique_ptr<wire_capture> cap) {
+            capture_.swap(cap);
+            return cap;
+        }
+        const wire_capture* capture() const { return capture_.get(); }
+
+    private:
+        // FIFO of queued commands on a power-of-two ring that only grows, so steady-state
+        // push/pop never allocates (std::deque frees and re-allocates its blocks as it goes).
+        class job_ring {
+        public:
+            bool empty() const { return count_ == 0; }
+            void push(bus_job job) {
+                if (count_ == jobs_.size()) grow();
+                jobs_[(head_ + count_) & (jobs_.size() - 1)] = std::move(job);
+                ++count_;
+            }
+            bus_job pop() {
+                bus_job job = std::move(jobs_[head_]);
+                head_ = (head_ + 1) & (jobs_.size() - 1);
+                --count_;
+                return job;
+            }
+
+        private:
+            void grow() {
+                std::vector<bus_job> next(jobs_.empty() ? 4 : jobs_.size() * 2);
+                for (std::size_t i = 0; i < count_; ++i) next[i] = std::move(jobs_[(head_ + i) & (jobs_.size() - 1)]);
+                jobs_ = std::move(next);
+                head_ = 0;
+            }
+            std::vector<bus_job> jobs_;
+            std::size_t head_ = 0;
+            std::size_t count_ = 0;
+        };
+
+        struct client {
+            job_ring commands;
+            bool running = false;
+            bus_job slot;
+        };
+
+        client& at(std::size_t id) {
+            if (clients_.size() <= id) clients_.resize(id + 1);
+            return clients_[id];
+        }
+
+        void pump_commands(std::size_t id) {
+            client& c = at(id);
+            if (c.running || c.commands.empty()) return;
+            c.running = true;
+            bus_job command = c.commands.pop();
+            command();
+        }
+
+        void pump_slots() {
+            if (busy_) return;
+            for (std::size_t k = 0; k < clients_.size(); ++k) {
+                const std::size_t id = (next_slot_ + k) % clients_.size();
+                if (!clients_[id].slot) continue;
+                busy_ = true;
+                next_slot_ = id + 1;
+                bus_job slot = std::move(clients_[id].slot);
+                slot();
+                return;
+            }
+        }
+
+        void discard_input() { flushed_.fetch_add(port_->discard_input(), std::memory_order_relaxed); }
+
+        // Copy the parser's counters to where metrics() reads them.
+        void publish_counters() {
+            const modbus::rtu_parser::stats& st = rx_.counters();
+            parser_discarded_.store(st.discarded, std::memory_order_relaxed);
+            parser_crc_errors_.store(st.crc_errors, std::memory_order_relaxed);
+            parser_resyncs_.store(st.resyncs, std::memory_order_relaxed);
+            unmatched_pub_.store(unmatched_, std::memory_order_relaxed);
+        }
+
+        // The transaction in progress; handlers of an earlier one see a different gen and
+        // stand down.
+        struct txn_state {
+            uint64_t gen = 0;
+            bool finished = true;
+            uint8_t slave = k_slave_addr;
+            wire_op op = wire_op::other;
+            uint8_t func = 0;
+            uint8_t tx[256];
+            uint8_t chunk[64];
+            uint64_t crc_errors = 0; // parser count when the request went out
+            uint8_t* out = nullptr;
+            std::size_t cap = 0;
+            reply_result result;
+            unique_callback<void(reply_result)> done;
+        };
+
+        void txn_begin(std::chrono::microseconds timeout, unique_callback<void(reply_result)> done) {
+            ++txn_.gen;
+            txn_.finished = false;
+            txn_.result = reply_result{};
+            txn_.done = std::move(done);
+            const uint64_t gen = txn_.gen;
+            deadline_timer_.expires_after(timeout);
+            deadline_timer_.async_wait(pooled([this, gen](const asio::error_code& ec) {
+                if (ec || gen != txn_.gen || txn_.finished) return;
+                // A corrupted reply was skipped by the parser: report that, not silence
+                txn_finish(rx_.counters().crc_errors != txn_.crc_errors ? reply_status::crc_error
+                                                                         : reply_status::timeout);
+            }));
+        }
+
+        // Single exit of a transaction: stop the timers, abandon any outstanding read, report.
+        void txn_finish(reply_status status) {
+            txn_.finished = true;
+            txn_.result.status = status;
+            publish_counters();
+            if (capture_) {
+                const uint8_t st = static_cast<uint8_t>(status);
+                capture_->record(wire_capture::kind::result, wire_capture::crc_state::none, txn_.op, &st, 1);
+            }
+            deadline_timer_.cancel();
+            gap_timer_.cancel();
+            port_->cancel();
+            auto done = std::move(txn_.done);
+            done(txn_.result);
+        }
+
+        // Event-driven reply read: every chunk goes through the RTU parser, and the
+        // transaction completes on the first frame that answers it (same slave, same
+        // function or its exception, and for writes the echoed address) instead of after a
+        // fixed wait. Other frames are counted as unmatched and skipped. A partial frame
+        // survives a t3.5 gap while it can still become the reply, since USB adapters hand
+        // over frames in latency-timer sized pieces; anything else is dropped at the gap.
+        void start_reply_chunk(uint64_t gen) {
+            port_->async_read_some(txn_.chunk, sizeof(txn_.chunk), [this, gen](asio::error_code ec, std::size_t n) {
+                if (gen != txn_.gen || txn_.finished) return;
+                on_reply_chunk(ec, n);
+            });
+        }
+
+        void on_reply_chunk(const asio::error_code& ec, std::size_t n) {
+            if (ec) {
+                txn_finish(reply_status::io_error);
+                return;
+            }
+            rx_.feed(txn_.chunk, n);
+            const modbus::rtu_parser::stats before = rx_.counters();
+            const uint8_t* f = nullptr;
+            while (const std::size_t len = rx_.next(&f)) {
+                if (!answers_request(f, len)) {
+                    ++unmatched_;
+                    continue;
+                }
+                capture_rx(n, before);
+                if (f[1] != txn_.func) {
+                    txn_.result.exception_code = f[2];
+                    txn_finish(reply_status::exception);
+                } else if (len > txn_.cap) {
+                    txn_finish(reply_status::io_error);
+                } else {
+                    std::copy(f, f + len, txn_.out);
+                    txn_.result.len = len;
+                    txn_finish(reply_status::ok);
+                }
+                return;
+            }
+            capture_rx(n, before);
+
+            // Re-arm the t3.5 boundary timer; only foreign bytes are thrown away when it fires.
+            const uint64_t gen = txn_.gen;
+            gap_timer_.expires_after(inter_frame_gap(baud_));
+            gap_timer_.async_wait(pooled([this, gen](const asio::error_code& gec) {
+                if (gec || gen != txn_.gen || txn_.finished) return;
+                if (!is_reply_prefix(txn_.slave, txn_.func, rx_.pending_data(), rx_.pending())) rx_.discard_pending();
+            }));
+            start_reply_chunk(gen);
+        }
+
+        // Log a received chunk, marked with what the parser made of it.
+        void capture_rx(std::size_t n, const modbus::rtu_parser::stats& before) {
+            if (!capture_) return;
+            const modbus::rtu_parser::stats& now = rx_.counters();
+            const wire_capture::crc_state crc = now.crc_errors != before.crc_errors ? wire_capture::crc_state::bad
+                                              : now.frames != before.frames       ? wire_capture::crc_state::ok
+                                                                                  : wire_capture::crc_state::none;
+            capture_->record(wire_capture::kind::rx, crc, txn_.op, txn_.chunk, n);
+        }
+
+        // Is frame f the reply to the request in txn_.tx?
+        bool answers_request(const uint8_t* f, std::size_t len) const {
+            if (f[0] != txn_.slave || (f[1] & 0x7F) != txn_.func) return false;
+            if (f[1] & 0x80) return true;
+            // Write echoes repeat the start address
+            if (txn_.func == 0x05 || txn_.func == 0x06 || txn_.func == 0x0F || txn_.func == 0x10)
+                return len >= 4 && f[2] == txn_.tx[2] && f[3] == txn_.tx[3];
+            return true;
+        }
+
+        asio::io_context& io_;
+        std::unique_ptr<transport> port_;
+        asio::steady_timer deadline_timer_;
+        asio::steady_timer gap_timer_;
+        std::string name_;
+        std::atomic<unsigned> baud_{k_default_baud};
+        low_latency_report latency_;
+        std::atomic<std::size_t> next_client_{0};
+        std::vector<client> clients_; // I/O thread only, like everything below
+        std::size_t next_slot_ = 0;
+        bool busy_ = false;
+        txn_state txn_;
+        modbus::rtu_parser rx_;
+        uint64_t unmatched_ = 0;
+        std::unique_ptr<wire_capture> capture_;
+        std::atomic<uint64_t> flushed_{0};
+        std::atomic<uint64_t> parser_discarded_{0};
+        std::atomic<uint64_t> parser_crc_errors_{0};
+        std::atomic<uint64_t> parser_resyncs_{0};
+        std::atomic<uint64_t> unmatched_pub_{0};
+    };
+
+    // Standalone controller for slave 0x01: owns its serial_bus and the I/O thread that
+    // drives it, started here and joined by the destructor.
+    act_controller()
+        : act_controller([](asio::io_context& io) { return std::make_unique<serial_transport>(io); }) {}
+
+    // Same, on another transport: act_controller(act_controller::simulated(sim)) drives
+    // an in-process simulated_actuator.
+    explicit act_controller(const transport_factory& make)
+        : own_io_(std::make_unique<asio::io_context>()), own_work_(asio::make_work_guard(*own_io_)),
+          bus_(std::make_shared<serial_bus>(*own_io_, make(*own_io_))), client_(bus_->add_client()),
+          slave_(k_slave_addr), owns_bus_(true), pause_timer_(*own_io_), telemetry_timer_(*own_io_),
+          connected_(false) {
+        io_thread_ = std::thread([this] { run_io(*own_io_); });
+    }
+
+    // One arm on a shared line (see act_controller_pool): frames go to `slave`, and the
+    // bus's io_context is driven by whoever created it. connect() then only probes and
+    // initializes this slave; the port itself is opened by the bus owner.
+    act_controller(std::shared_ptr<serial_bus> bus, uint8_t slave)
+        : bus_(std::move(bus)), client_(bus_->add_client()), slave_(slave), owns_bus_(false),
+          pause_timer_(bus_->io()), telemetry_timer_(bus_->io()), connected_(false) {}
+
+    // Must not run on the I/O thread (i.e. inside a completion handler). Waits for the
+    // arm's queued commands, so nothing still refers to it afterwards.
+    ~act_controller() {
+        stop_telemetry();
+        if (owns_bus_) {
+            close_port();
+            own_work_.reset();
+            io_thread_.join();
+        } else {
+            call_on_bus([] {});
+        }
+    }
+
+    act_controller(const act_controller&) = delete;
+    act_controller& operator=(const act_controller&) = delete;
+
+    void init() {
+        // No-op for now. Reserved for future setup.
+    }
+    // Hàm này có lỗi. Có thể phải thay bằng hàm m đã viết.
+    
+    struct probe_result {
+        std::string port;
+        std::chrono::microseconds latency{0}; // probe write -> CRC-valid reply
+        unsigned baud = k_default_baud;
+    };
+
+    // Probe all candidate ports concurrently on one io_context, at one line rate. Every
+    // port gets a hard deadline, so a silent or wedged device costs per_port_timeout at
+    // most and the whole scan finishes in about one timeout. With first_only the scan
+    // stops at the first responsive controller; otherwise all of them are returned,
+    // fastest first.
+    static std::vector<probe_result> discover(const std::vector<std::string>& candidates,
+                                              std::chrono::milliseconds per_port_timeout =
+                                                  std::chrono::milliseconds(k_probe_timeout_ms),
+                                              bool first_only = false,
+                                              unsigned baud = k_default_baud) {
+        asio::io_context io;
+        discovery_run run(io, first_only, baud);
+        for (const auto& name : candidates) run.start(name, per_port_timeout);
+        io.run();
+        std::sort(run.results.begin(), run.results.end(),
+                  [](const probe_result& a, const probe_result& b) { return a.latency < b.latency; });
+        return run.results;
+    }
+
+    // A serial device found by enumerate_ports(). USB fields are 0 / empty for on-board UARTs.
+    struct port_info {
+        std::string device;         // /dev/ttyUSB0, COM7
+        std::string by_id;          // /dev/serial/by-id/... link, if udev made one
+        uint16_t vid = 0;
+        uint16_t pid = 0;
+        std::string serial;         // USB adapter serial number
+        std::string product;
+        int score = 0;              // set by rank_ports(); higher is tried first
+    };
+
+    // What identified the controller the last time connect() succeeded.
+    struct port_fingerprint {
+        std::string device;
+        std::string adapter_serial;
+        uint16_t vid = 0;
+        uint16_t pid = 0;
+        bool valid() const { return !device.empty(); }
+    };
+
+    // Serial devices actually present: /sys/class/tty entries backed by hardware (USB
+    // adapters, CDC-ACM, UARTs whose type is not PORT_UNKNOWN), with USB VID/PID and
+    // serial number from sysfs and the /dev/serial/by-id alias. Virtual consoles and
+    // absent legacy ttyS ports are skipped. Empty where sysfs is unavailable.
+    static std::vector<port_info> enumerate_ports() {
+        std::vector<port_info> out;
+#ifdef __linux__
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        const fs::path tty_root("/sys/class/tty");
+        if (!fs::exists(tty_root, ec)) return out;
+
+        // by-id aliases, keyed by the device they resolve to
+        std::vector<std::pair<std::string, std::string>> aliases;
+        for (const auto& e : fs::directory_iterator("/dev/serial/by-id", ec)) {
+            const auto target = fs::canonical(e.path(), ec);
+            if (!ec) aliases.emplace_back(target.string(), e.path().string());
+        }
+
+        for (const auto& e : fs::directory_iterator(tty_root, ec)) {
+            const std::string name = e.path().filename().string();
+            if (!fs::exists(e.path() / "device", ec)) continue; // virtual console / pty
+            const std::string type = read_sysfs(e.path() / "type");
+            if (!type.empty() && type == "0") continue;          // UART slot with no chip
+            port_info pi;
+            pi.device = "/dev/" + name;
+            if (!fs::exists(pi.device, ec)) continue;
+            for (const auto& a : aliases)
+                if (a.first == pi.device) pi.by_id = a.second;
+            // Walk up from the tty's device to the USB device node (the one with idVendor)
+            fs::path dev = fs::canonical(e.path() / "device", ec);
+            for (int depth = 0; !ec && depth < 4 && dev.has_parent_path(); ++depth, dev = dev.parent_path()) {
+                if (fs::exists(dev / "idVendor", ec)) {
+                    pi.vid = static_cast<uint16_t>(std::strtoul(read_sysfs(dev / "idVendor").c_str(), nullptr, 16));
+                    pi.pid = static_cast<uint16_t>(std::strtoul(read_sysfs(dev / "idProduct").c_str(), nullptr, 16));
+                    pi.serial = read_sysfs(dev / "serial");
+                    pi.product = read_sysfs(dev / "product");
+                    break;
+                }
+            }
+            out.push_back(std::move(pi));
+        }
+        std::sort(out.begin(), out.end(),
+                  [](const port_info& a, const port_info& b) { return a.device < b.device; });
+#endif
+        return out;
+    }
+
+    // Order ports by likelihood of being the arm: same adapter serial as last time beats
+    // same device name, which beats same VID/PID; any USB adapter beats on-board UARTs.
+    // A re-plugged adapter is found again even when it comes back as a different ttyUSBn.
+    static void rank_ports(std::vector<port_info>& ports, const port_fingerprint& last) {
+        for (auto& p : ports) {
+            p.score = 0;
+            if (p.vid != 0) p.score += 10;
+            if (last.valid()) {
+                if (!last.adapter_serial.empty() && p.serial == last.adapter_serial) p.score += 100;
+                if (p.device == last.device) p.score += 50;
+                if (last.vid != 0 && p.vid == last.vid && p.pid == last.pid) p.score += 20;
+            }
+        }
+        std::stable_sort(ports.begin(), ports.end(),
+                         [](const port_info& a, const port_info& b) { return a.score > b.score; });
+    }
+
+    static port_fingerprint load_port_fingerprint(const std::string& path) {
+        port_fingerprint fp;
+        if (path.empty()) return fp;
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            const auto eq = line.find('=');
+            if (eq == std::string::npos) continue;
+            const std::string key = line.substr(0, eq), val = line.substr(eq + 1);
+            if (key == "device") fp.device = val;
+            else if (key == "adapter_serial") fp.adapter_serial = val;
+            else if (key == "vid") fp.vid = static_cast<uint16_t>(std::strtoul(val.c_str(), nullptr, 16));
+            else if (key == "pid") fp.pid = static_cast<uint16_t>(std::strtoul(val.c_str(), nullptr, 16));
+        }
+        return fp;
+    }
+
+    static bool save_port_fingerprint(const std::string& path, const port_fingerprint& fp) {
+        if (path.empty()) return false;
+        std::error_code ec;
+        const std::filesystem::path p(path);
+        if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path(), ec);
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) return false;
+        char hex[8];
+        out << "device=" << fp.device << "\n";
+        out << "adapter_serial=" << fp.adapter_serial << "\n";
+        std::snprintf(hex, sizeof(hex), "%04x", fp.vid);
+        out << "vid=" << hex << "\n";
+        std::snprintf(hex, sizeof(hex), "%04x", fp.pid);
+        out << "pid=" << hex << "\n";
+        return static_cast<bool>(out);
+    }
+
+    // Where connect() keeps the last-known-good fingerprint; empty disables the cache.
+    void set_port_cache_path(const std::string& path) { port_cache_path_ = path; }
+    const std::string& get_port_cache_path() const { return port_cache_path_; }
+
+    // Auto-connect to the first responsive controller on COM1..COM32.
+    // Returns 0 if successful, non-zero otherwise.
+    int connect(const std::string& user_com_port = std::string()) {
+        // Prefer explicit port (or platform default) before scanning
+        if (connected_) return 0;
+        if (!owns_bus_) return connect_on_bus();
+        if (!bus_->is_serial()) return connect_direct(user_com_port);
+        bool had_user = !user_com_port.empty();
+        std::string requested = user_com_port;
+        // Real serial devices, best match for the last-known-good controller first
+        std::vector<port_info> ranked = enumerate_ports();
+        rank_ports(ranked, load_port_fingerprint(port_cache_path_));
+#ifdef _WIN32
+        const std::string fallback = std::string("COM7");
+#else
+        const std::string fallback = std::string("/dev/ttyUSB0");
+#endif
+        const std::string preferred = had_user ? user_com_port
+                                               : (ranked.empty() ? fallback : ranked.front().device);
+        try {
+            call_on_bus([&] { open_and_configure(preferred, line_.baud); });
+
+            // Probe to ensure it's responsive
+            uint8_t rx[256];
+            const reply_result probe = transact(k_probe_frame.data(), k_probe_frame.size(), rx, sizeof(rx), wire_op::probe);
+            if (probe.status == reply_status::ok) {
+                // Same initialization sequence as below
+                if (!run_init_sequence()) {
+                    close_port();
+                    return 1;
+                }
+                remember_port(preferred);
+                connected_ = true;
+                connects_.fetch_add(1, std::memory_order_relaxed);
+                port_name_ = preferred;
+                if (had_user && preferred != requested) {
+                    std::cout << "[port-info] Requested " << requested << " connected as " << preferred << std::endl;
+                }
+                return 0;
+            }
+        } catch (...) {
+            close_port();
+            connected_ = false;
+            port_name_.clear();
+            // fall through to the existing scan below
+        }
+        if (connected_) return 0;
+        close_port();
+        try {
+            // Scan for responsive COM ports, all at once (bounded by one probe timeout).
+            // Only enumerated serial devices are tried; the blind name list is the fallback
+            // when enumeration is unavailable (Windows, no sysfs).
+            // With auto_detect, the requested port, or without one every port (the
+            // preferred one too), is tried again at each other candidate rate, one scan per rate.
+            std::vector<std::string> candidates;
+            for (const auto& pi : ranked) candidates.push_back(pi.device);
+            if (candidates.empty()) candidates = make_port_list();
+            candidates.erase(std::remove(candidates.begin(), candidates.end(), preferred), candidates.end());
+            std::vector<probe_result> found =
+                discover(candidates, std::chrono::milliseconds(k_probe_timeout_ms), true, line_.baud);
+            if (found.empty() && line_.auto_detect) {
+                if (had_user) candidates.clear();
+                candidates.insert(candidates.begin(), preferred);
+                for (unsigned rate : line_.candidates) {
+                    if (rate == line_.baud) continue;
+                    found = discover(candidates, std::chrono::milliseconds(k_probe_timeout_ms), true, rate);
+                    if (!found.empty()) break;
+                }
+            }
+            // Reopen the first port that answered discovery and probe it again; one that
+            // does not answer now is closed and the next one tried.
+            std::string name;
+            uint8_t rx[256];
+            for (const probe_result& hit : found) {
+                call_on_bus([&] { open_and_configure(hit.port, hit.baud); });
+                const reply_result probe = transact(k_probe_frame.data(), k_probe_frame.size(), rx, sizeof(rx), wire_op::probe);
+                if (probe.status != reply_status::ok) {
+                    std::cout << "[port-error] " << hit.port << " answered discovery but not the probe ("
+                              << reply_status_name(probe.status) << ")" << std::endl;
+                    close_port();
+                    continue;
+                }
+                name = hit.port;
+                if (hit.baud != line_.baud) {
+                    std::cout << "[port-info] " << name << " answered at " << hit.baud
+                              << " baud (configured " << line_.baud << ")" << std::endl;
+                    line_.baud = hit.baud;
+                }
+                break;
+            }
+            if (name.empty()) {
+                if (had_user)
+                    std::cout << "[port-error] Requested " << requested << " not found or unresponsive." << std::endl;
+                return 1;
+            }
+            if (had_user && name != requested) {
+                std::cout << "[port-info] Requested " << requested << " not responsive, using " << name << std::endl;
+            }
+            // ...existing initialization sequence (same as above)...
+            if (!run_init_sequence()) {
+                close_port();
+                return 1;
+            }
+            remember_port(name);
+            connected_ = true;
+            connects_.fetch_add(1, std::memory_order_relaxed);
+            port_name_ = name;
+            return 0;
+        } catch (...) {
+            close_port();
+            connected_ = false;
+            port_name_.clear();
+            return 1;
+        }
+    }
+        // Reset controller (reverse engineered)
+    void reset() {
+        if (!connected_) return;
+        // Captured sequence; earlier captures also replayed the full connect() init
+        // block and repeated 0x0380 probes here, which turned out to be unnecessary.
+        static constexpr std::array<modbus::frame<8>, 4> seq = {
+            modbus::checked({0x01, 0x03, 0x03, 0x80, 0x00, 0x40, 0x45, 0x96}),
+            // reset command
+            modbus::checked({0x01, 0x05, 0x00, 0x45, 0xff, 0x00, 0x9d, 0xef}),
+            modbus::checked({0x01, 0x05, 0x00, 0x1c, 0xff, 0x00, 0x4d, 0xfc}), // added
+            modbus::checked({0x01, 0x05, 0x00, 0x1c, 0x00, 0x00, 0x0c, 0x0c})  // added
+        };
+        command_batch batch;
+        batch.op = wire_op::reset;
+        for (const auto& frame : seq) batch.add(frame);
+        wait_sync([&](auto cb) { async_run_batch(batch, std::move(cb)); });
+    }
+
+
+    // Close the serial connection if open. An arm on a shared line leaves the line open.
+    void disconnect() {
+        stop_telemetry();
+        if (owns_bus_) close_port();
+        connected_ = false;
+        known_position_.store(k_position_unknown, std::memory_order_relaxed);
+        port_name_.clear();
+    }
+
+    // Move to origin (placeholder - no specific origin command known; implement when available).
+    // For now, just move to absolute position 0.
+    void move_to_origin() {
+        move_absolute(0);
+    }
+
+    // Move relative by magnitude (positive or negative).
+    void move_relative(int magnitude, int move_speed /* [1..30] */ = 10) {
+        if (!connected_ || magnitude == 0) return;
+        wait_sync([&](auto cb) { async_move_relative(magnitude, move_speed, std::move(cb)); });
+    }
+
+    // Move to absolute position (units in same external unit as get_current_position()).
+    // Internally scale by 100 to device units (big-endian 16-bit).
+    void move_absolute(int position, int speed = 10) {
+        if (!connected_) return;
+        wait_sync([&](auto cb) { async_move_absolute(position, speed, std::move(cb)); });
+    }
+
+    // Returns true if connected.
+    bool is_connected() const {
+        return connected_;
+    }
+
+    // Returns current position in external unit (scaled down by 100).
+    // If unavailable, returns 0. With telemetry running this is the latest published
+    // sample and costs no bus traffic, unless there is none yet or it is stale.
+    int get_current_position() {
+        if (!connected_) return 0;
+        if (const std::optional<position_sample> smp = fresh_sample()) return smp->position;
+        require_caller_thread();
+        sync_waiter w;
+        int pos = 0;
+        async_get_position([&](const asio::error_code&, int p) {
+            pos = p;
+            w.signal();
+        });
+        w.wait();
+        return pos;
+    }
+
+    // Position and status word in one minimal read (0x9000..0x9001), decoded with the
+    // status_bits masks. With telemetry running this is the latest sample (no bus traffic)
+    // while it is fresh. On failure the snapshot is zeroed with an epoch timestamp.
+    status_snapshot read_status() {
+        if (!connected_) return status_snapshot();
+        if (const std::optional<position_sample> smp = fresh_sample())
+            return decode_status(smp->status, static_cast<int16_t>(smp->raw), smp->timestamp);
+        require_caller_thread();
+        sync_waiter w;
+        status_snapshot out;
+        async_read_status([&](const asio::error_code&, status_snapshot st) {
+            out = st;
+            w.signal();
+        });
+        w.wait();
+        return out;
+    }
+
+    // All 16 registers of the position block, for diagnostics; always goes to the bus.
+    status_block read_status_block() {
+        if (!connected_) return status_block();
+        require_caller_thread();
+        sync_waiter w;
+        status_block out;
+        async_read_status_block([&](const asio::error_code&, status_block b) {
+            out = b;
+            w.signal();
+        });
+        w.wait();
+        return out;
+    }
+
+    // Which status word bits mean busy / in position / alarm. Takes effect on the next read.
+    void set_status_bits(const status_bits& bits) {
+        status_busy_mask_ = bits.busy;
+        status_in_position_mask_ = bits.in_position;
+        status_alarm_mask_ = bits.alarm;
+    }
+
+    status_bits get_status_bits() const {
+        status_bits b;
+        b.busy = status_busy_mask_;
+        b.in_position = status_in_position_mask_;
+        b.alarm = status_alarm_mask_;
+        return b;
+    }
+
+    // Asynchronous API. Each call queues one bus job on the I/O thread and returns at
+    // once; the job runs when the bus is free (jobs never interleave on the wire) and the
+    // result goes to the completion token: a callback, asio::use_future, or
+    // asio::use_awaitable in a coroutine. Handlers run on their associated executor, by
+    // default inline on the I/O thread, so they must not call the synchronous methods.
+    //
+    // Signature void(asio::error_code): same frames and pacing as the synchronous moves;
+    // the error is set when the port is closed or a write fails.
+    template <typename CompletionToken>
+    async_result_t<CompletionToken, void(asio::error_code)>
+    async_move_relative(int magnitude, int move_speed, CompletionToken&& token) {
+        int spd = move_speed;
+        if (spd < 1) spd = 1;
+        else if (spd > 30) spd = 30;
+        command_batch batch;
+        if (magnitude != 0) batch = relative_move_batch(magnitude, spd);
+        return async_run_batch(batch, std::forward<CompletionToken>(token));
+    }
+
+    // Sent per absolute_mode: in fast mode (opt-in) the command completes once the start
+    // pulse is acknowledged, a few wire times instead of about 500 ms.
+    template <typename CompletionToken>
+    async_result_t<CompletionToken, void(asio::error_code)>
+    async_move_absolute(int position, int speed, CompletionToken&& token) {
+        return asio::async_initiate<CompletionToken, void(asio::error_code)>(
+            [this](auto handler, int pos, int spd) {
+                auto work = asio::make_work_guard(asio::get_associated_executor(handler, io().get_executor()));
+                post_job(wire_op::move_absolute, [this, pos, spd, h = std::move(handler), w = std::move(work)]() mutable {
+                    run_absolute(pos, spd, [this, h = std::move(h), w = std::move(w)](asio::error_code ec) mutable {
+                        finish_command();
+                        complete(std::move(h), ec);
+                    });
+                });
+            },
+            token, position, speed);
+    }
+
+    // Signature void(asio::error_code, int): position in external units, 0 on error
+    // (error category reply_category(), e.g. timeout or CRC error).
+    template <typename CompletionToken>
+    async_result_t<CompletionToken, void(asio::error_code, int)>
+    async_get_position(CompletionToken&& token) {
+        return asio::async_initiate<CompletionToken, void(asio::error_code, int)>(
+            [this](auto handler) {
+                auto work = asio::make_work_guard(asio::get_associated_executor(handler, io().get_executor()));
+                post_job(wire_op::position, [this, h = std::move(handler), w = std::move(work)]() mutable {
+                    read_status_regs([this, h = std::move(h), w = std::move(w)](asio::error_code ec, uint16_t, int16_t raw) mutable {
+                        finish_command();
+                        complete(std::move(h), ec, ec ? 0 : scale_position(raw));
+                    });
+                });
+            },
+            token);
+    }
+
+    // Signature void(asio::error_code, status_snapshot): one minimal status read.
+    template <typename CompletionToken>
+    async_result_t<CompletionToken, void(asio::error_code, status_snapshot)>
+    async_read_status(CompletionToken&& token) {
+        return asio::async_initiate<CompletionToken, void(asio::error_code, status_snapshot)>(
+            [this](auto handler) {
+                auto work = asio::make_work_guard(asio::get_associated_executor(handler, io().get_executor()));
+                post_job(wire_op::status, [this, h = std::move(handler), w = std::move(work)]() mutable {
+                    read_status_regs([this, h = std::move(h), w = std::move(w)](asio::error_code ec, uint16_t status, int16_t raw) mutable {
+                        finish_command();
+                        complete(std::move(h), ec,
+                                 ec ? status_snapshot() : decode_status(status, raw, std::chrono::steady_clock::now()));
+                    });
+                });
+            },
+            token);
+    }
+
+    // Signature void(asio::error_code, status_block): the full 16-register block.
+    template <typename CompletionToken>
+    async_result_t<CompletionToken, void(asio::error_code, status_block)>
+    async_read_status_block(CompletionToken&& token) {
+        return asio::async_initiate<CompletionToken, void(asio::error_code, status_block)>(
+            [this](auto handler) {
+                auto work = asio::make_work_guard(asio::get_associated_executor(handler, io().get_executor()));
+                post_job(wire_op::status, [this, h = std::move(handler), w = std::move(work)]() mutable {
+                    read_block([this, h = std::move(h), w = std::move(w)](asio::error_code ec) mutable {
+                        finish_command();
+                        status_block b;
+                        if (!ec) {
+                            for (std::size_t i = 0; i < b.words.size(); ++i) b.words[i] = be16(job_rx_ + 3 + 2 * i);
+                            b.status = decode_status(b.words[0], static_cast<int16_t>(b.words[1]),
+                                                     std::chrono::steady_clock::now());
+                        }
+                        complete(std::move(h), ec, b);
+                    });
+                });
+            },
+            token);
+    }
+
+    // One point of a trajectory: absolute target (external units), speed, and how long
+    // to hold there before the next segment starts.
+    struct waypoint {
+        int position = 0;
+        int speed = 10;
+        std::chrono::milliseconds dwell{0};
+    };
+
+    struct trajectory_options {
+        int tolerance = 1;                                // in-position window, external units
+        std::chrono::milliseconds poll{10};               // position poll period while moving
+        std::chrono::milliseconds segment_timeout{10000}; // give up on a segment after this
+        // Write the next segment's speed/position while the current one runs, so only the
+        // start pulse is left once in position. Relies on the controller latching
+        // 0x0411..0x0413 at the start pulse, which has not been confirmed on hardware yet
+        // (a drive that applies them at once would retarget the running move), hence off by
+        // default. If a preload write is refused the segment is loaded after arrival instead.
+        bool lookahead = false;
+    };
+
+    // Outcome of one segment; times are measured from the start of the trajectory.
+    struct segment_result {
+        int commanded = 0;                        // target after clamping, external units
+        int reached = 0;                          // last position read
+        bool arrived = false;                     // within tolerance before segment_timeout
+        bool preloaded = false;                   // parameters went out during the previous segment
+        asio::error_code error;                   // what ended the segment early, if anything
+        std::chrono::microseconds triggered{0};   // start pulse acknowledged
+        std::chrono::microseconds in_position{0}; // first read within tolerance
+    };
+
+    // Run a list of absolute waypoints as one command on this arm. Every frame is
+    // acknowledged by the controller instead of being followed by a fixed sleep, the next
+    // segment is triggered as soon as a position read is in tolerance (plus its dwell),
+    // and with lookahead its parameters are already loaded by then. Stops at the first
+    // segment that fails. Signature void(asio::error_code, std::vector<segment_result>):
+    // one result per segment attempted; the error is that segment's error, or
+    // asio::error::timed_out when it did not arrive.
+    template <typename CompletionToken>
+    async_result_t<CompletionToken, void(asio::error_code, std::vector<segment_result>)>
+    async_run_trajectory(std::vector<waypoint> points, const trajectory_options& opt, CompletionToken&& token) {
+        return asio::async_initiate<CompletionToken, void(asio::error_code, std::vector<segment_result>)>(
+            [this](auto handler, std::vector<waypoint> pts, const trajectory_options& o) {
+                auto work = asio::make_work_guard(asio::get_associated_executor(handler, io().get_executor()));
+                post_job(wire_op::trajectory, [this, pts = std::move(pts), o, h = std::move(handler), w = std::move(work)]() mutable {
+                    start_trajectory(std::move(pts), o, [this, h = std::move(h), w = std::move(w)](asio::error_code ec) mutable {
+                        finish_command();
+                        complete(std::move(h), ec, std::move(traj_.results));
+                    });
+                });
+            },
+            token, std::move(points), opt);
+    }
+
+    // Blocking form; check the last result's arrived/error for the outcome.
+    std::vector<segment_result> run_trajectory(const std::vector<waypoint>& points, const trajectory_options& opt) {
+        require_caller_thread();
+        sync_waiter w;
+        std::vector<segment_result> out;
+        async_run_trajectory(points, opt, [&](const asio::error_code&, std::vector<segment_result> r) {
+            out = std::move(r);
+            w.signal();
+        });
+        w.wait();
+        return out;
+    }
+
+    std::vector<segment_result> run_trajectory(const std::vector<waypoint>& points) {
+        return run_trajectory(points, trajectory_options());
+    }
+
+    // Latest position published by the telemetry poller. Lock-free (seqlock): readers
+    // retry if the writer was mid-update, never block it. sequence == 0 means no sample yet.
+    position_sample latest_sample() const {
+        position_sample out;
+        for (;;) {
+            const uint64_t s1 = sample_seq_.load(std::memory_order_acquire);
+            if (s1 & 1) continue; // writer in progress
+            const int32_t pos = sample_position_.load(std::memory_order_relaxed);
+            const int32_t raw = sample_raw_.load(std::memory_order_relaxed);
+            const uint16_t status = sample_status_.load(std::memory_order_relaxed);
+            const int64_t ts = sample_time_ns_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sample_seq_.load(std::memory_order_relaxed) != s1) continue;
+            out.position = pos;
+            out.raw = raw;
+            out.status = status;
+            out.timestamp = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(ts));
+            out.sequence = s1 / 2;
+            return out;
+        }
+    }
+
+    // Poll the position register every `period` on the I/O thread and publish the result;
+    // get_current_position() and the blocking moves then read the sample instead of
+    // issuing their own requests. Polls are ordinary bus jobs, so commands queue behind at
+    // most one in-flight poll.
+    bool start_telemetry(std::chrono::milliseconds period = std::chrono::milliseconds(20)) {
+        if (!connected_ || telemetry_running()) return false;
+        telemetry_period_ = std::max(period, std::chrono::milliseconds(1));
+        telemetry_on_ = true;
+        asio::post(io(), [this] {
+            telemetry_next_ = std::chrono::steady_clock::now();
+            telemetry_poll(++telemetry_gen_);
+        });
+        return true;
+    }
+
+    void stop_telemetry() {
+        if (!telemetry_running()) return;
+        call_on_io([this] {
+            ++telemetry_gen_;
+            telemetry_timer_.cancel();
+        });
+        telemetry_on_ = false;
+    }
+
+    bool telemetry_running() const { return telemetry_on_.load(std::memory_order_acquire); }
+
+    // The telemetry sample, if telemetry is running, has published one, and the last is
+    // at most two periods old (a poll stuck behind a long command, or failing, is not
+    // answered from the past).
+    std::optional<position_sample> fresh_sample() const {
+        if (!telemetry_running()) return std::nullopt;
+        const position_sample smp = latest_sample();
+        if (smp.sequence == 0 || std::chrono::steady_clock::now() - smp.timestamp > 2 * telemetry_period_)
+            return std::nullopt;
+        return smp;
+    }
+
+    // Where the arm is known to be without asking it: the fresh telemetry sample, else
+    // where the last blocking move arrived if no motion command has been queued since.
+    std::optional<int> known_position() const {
+        if (const std::optional<position_sample> smp = fresh_sample()) return smp->position;
+        const int64_t p = known_position_.load(std::memory_order_relaxed);
+        if (p == k_position_unknown) return std::nullopt;
+        return static_cast<int>(p);
+    }
+
+    // Blocking variant: same motion as move_relative, but waits until target reached or timeout (seconds).
+    // Returns 0 on success, non-zero on timeout or invalid input; tolerance specifies acceptable position error.
+    int move_relative_blocking(int magnitude, int move_speed, int timeout_sec, int tolerance = 1) {
+        if (!connected_ || magnitude == 0 || timeout_sec <= 0) return 1;
+
+        // Compute expected target from current position before sending commands
+        int start_pos = get_current_position();
+        int expected = std::max(0, start_pos + magnitude);
+        int spd = move_speed;
+        std::cout << "Speed: " << spd << std::endl;
+        if (spd < 1) spd = 1; //else if (spd > 30) spd = 30;
+
+        // Send the same frames as move_relative (positive vs negative)
+        const auto issued = std::chrono::steady_clock::now();
+        wait_sync([&](auto cb) { async_run_batch(relative_move_batch(magnitude, spd), std::move(cb)); });
+        const auto sent = std::chrono::steady_clock::now();
+
+        // Wait for arrival (see wait_for_position) until target reached or timeout
+        using namespace std::chrono;
+        const auto deadline = steady_clock::now() + seconds(timeout_sec);
+        if (wait_for_position(expected, tolerance, deadline, sent, issued, start_pos, spd)) return 0;
+        return 1; // timeout
+    }
+
+    // Blocking variant: same as move_absolute, but waits until target reached or timeout (seconds).
+    // Returns 0 on success, non-zero on timeout/invalid input; tolerance specifies acceptable position error.
+    int move_absolute_blocking(int position, int speed, int timeout_sec, int tolerance = 1) {
+        if (!connected_ || timeout_sec <= 0) return 1;
+        if (speed < 1) speed = 1;
+        // else if (speed > 30) speed = 30; // (unclamped upper if intentional)
+
+        // Compute expected target (external units) with same clamp/scale as move_absolute
+        int scaled = position * 100;
+        if (scaled < 0) scaled = 0;
+        if (scaled > 0xFFFF) scaled = 0xFFFF;
+        const int expected = static_cast<int>((scaled + 50) / 100); // rounded to nearest ext unit
+
+        // Distance feeds the arrival estimate, but is not worth a bus read of its own:
+        // without a telemetry sample or a previous arrival the move goes unpredicted
+        const std::optional<int> start_pos = known_position();
+        const auto issued = std::chrono::steady_clock::now();
+        move_absolute(position, speed);
+        const auto sent = std::chrono::steady_clock::now();
+
+        // Wait for arrival (see wait_for_position) until target reached or timeout
+        using namespace std::chrono;
+        const auto deadline = steady_clock::now() + seconds(timeout_sec);
+        if (wait_for_position(expected, tolerance, deadline, sent, issued, start_pos, speed)) return 0;
+        return 1; // timeout
+    }
+
+    // Arrival-time model fed by the blocking moves of this arm
+    motion_estimator& estimator() { return estimator_; }
+    const motion_estimator& estimator() const { return estimator_; }
+
+    settle_report last_settle_report() const {
+        std::lock_guard<std::mutex> lk(settle_mutex_);
+        return last_settle_;
+    }
+
+    const std::string& get_port_name() const { return port_name_; }
+
+    const init_report& last_init_report() const { return init_report_; }
+
+    // Receive-side counters of this arm's serial line: frames parsed, CRC failures, bytes
+    // skipped to resynchronize, frames that answered no request.
+    serial_bus::rx_stats framing_stats() {
+        serial_bus::rx_stats out;
+        call_on_io([&] { out = bus_->stats(); });
+        return out;
+    }
+
+    void set_transaction_policy(const transaction_policy& p) {
+        if (p.retries < 0 || !(p.rtt_factor > 0) || p.min_turnaround.count() < 0 ||
+            p.max_turnaround < p.min_turnaround)
+            throw std::invalid_argument("act_controller: bad transaction_policy");
+        std::lock_guard<std::mutex> lk(policy_mutex_);
+        policy_ = p;
+    }
+    transaction_policy get_transaction_policy() const {
+        std::lock_guard<std::mutex> lk(policy_mutex_);
+        return policy_;
+    }
 
-class act_controller {
-public:
-    act_controller()
-        : io_(), port_(io_), connected_(false) {}
+    // Measured turnaround (reply time minus wire time) over the last replies, and the
+    // retry and timeout counts of this arm.
+    transaction_stats get_transaction_stats() {
+        transaction_stats out;
+        call_on_io([&] {
+            out.samples = rtt_.count();
+            out.p50 = rtt_.percentile(0.5);
+            out.p99 = rtt_.percentile(0.99);
+            out.max = rtt_.percentile(1.0);
+            out.allowance = turnaround_allowance(get_transaction_policy(), true);
+            out.transactions = txn_count_;
+            out.retries = txn_retries_;
+            out.timeouts = txn_timeouts_;
+        });
+        return out;
+    }
 
-    void init() {
-        // No-op for now. Reserved for future setup.
+    // Everything the controller measures, read without waiting on the I/O thread (each
+    // field is consistent on its own, not with the others).
+    struct metrics_report {
+        // Bus time of each command by the API call it served (wire_op): from the moment
+        // it got the arm's queue to its last reply, so the frame pauses of a move count.
+        // wire_op::init stays empty: each init step has its own entry in init_steps.
+        std::array<latency_histogram::summary, k_wire_ops> commands;
+        std::array<latency_histogram::summary, k_init_steps> init_steps;
+        latency_histogram::summary transaction; // one request/reply attempt
+        latency_histogram::summary settle;      // blocking move: command sent -> arrival seen
+        uint64_t transactions = 0;
+        uint64_t retries = 0;
+        uint64_t timeouts = 0;
+        uint64_t crc_errors = 0;    // transactions that ended on a corrupted reply
+        uint64_t exceptions = 0;
+        uint64_t io_errors = 0;
+        uint64_t connects = 0;
+        uint64_t reconnects = 0;    // connects after the first
+        serial_bus::line_metrics line; // the whole line, all arms on it
+    };
+
+    metrics_report metrics_snapshot() const {
+        metrics_report m;
+        for (std::size_t i = 0; i < k_wire_ops; ++i) m.commands[i] = command_latency_[i].get();
+        for (std::size_t i = 0; i < k_init_steps; ++i) m.init_steps[i] = init_latency_[i].get();
+        m.transaction = txn_latency_.get();
+        m.settle = settle_latency_.get();
+        m.transactions = txn_count_.load(std::memory_order_relaxed);
+        m.retries = txn_retries_.load(std::memory_order_relaxed);
+        m.timeouts = txn_timeouts_.load(std::memory_order_relaxed);
+        m.crc_errors = txn_crc_errors_.load(std::memory_order_relaxed);
+        m.exceptions = txn_exceptions_.load(std::memory_order_relaxed);
+        m.io_errors = txn_io_errors_.load(std::memory_order_relaxed);
+        m.connects = connects_.load(std::memory_order_relaxed);
+        m.reconnects = m.connects > 0 ? m.connects - 1 : 0;
+        m.line = bus_->metrics();
+        return m;
     }
-    // Hàm này có lỗi. Có thể phải thay bằng hàm m đã viết.
-    
-    // Auto-connect to the first responsive controller on COM1..COM32.
-    // Returns 0 if successful, non-zero otherwise.
-    int connect(const std::string& user_com_port = std::string()) {
-        // Prefer explicit port (or platform default) before scanning
-        if (connected_) return 0;
-        bool had_user = !user_com_port.empty();
-        std::string requested = user_com_port;
-        try {
-#ifdef _WIN32
-            const std::string preferred = had_user ? user_com_port : std::string("COM7");
+
+    // Metrics over a window without resetting anything a scraper reads: take a mark, and
+    // metrics_since() later reports the samples and counts recorded after it.
+    struct metrics_mark {
+        std::array<latency_histogram::counts, k_wire_ops> commands;
+        std::array<latency_histogram::counts, k_init_steps> init_steps;
+        latency_histogram::counts transaction;
+        latency_histogram::counts settle;
+        metrics_report totals; // for the counters
+    };
+
+    metrics_mark mark_metrics() const {
+        metrics_mark m;
+        for (std::size_t i = 0; i < k_wire_ops; ++i) m.commands[i] = command_latency_[i].mark();
+        for (std::size_t i = 0; i < k_init_steps; ++i) m.init_steps[i] = init_latency_[i].mark();
+        m.transaction = txn_latency_.mark();
+        m.settle = settle_latency_.mark();
+        m.totals = metrics_snapshot();
+        return m;
+    }
+
+    metrics_report metrics_since(const metrics_mark& base) const {
+        metrics_report m = metrics_snapshot();
+        for (std::size_t i = 0; i < k_wire_ops; ++i) m.commands[i] = command_latency_[i].since(base.commands[i]);
+        for (std::size_t i = 0; i < k_init_steps; ++i) m.init_steps[i] = init_latency_[i].since(base.init_steps[i]);
+        m.transaction = txn_latency_.since(base.transaction);
+        m.settle = settle_latency_.since(base.settle);
+        const metrics_report& b = base.totals;
+        m.transactions -= b.transactions;
+        m.retries -= b.retries;
+        m.timeouts -= b.timeouts;
+        m.crc_errors -= b.crc_errors;
+        m.exceptions -= b.exceptions;
+        m.io_errors -= b.io_errors;
+        m.connects -= b.connects;
+        m.reconnects -= b.reconnects;
+        m.line.drained_bytes -= b.line.drained_bytes;
+        m.line.crc_errors -= b.line.crc_errors;
+        m.line.resyncs -= b.line.resyncs;
+        m.line.unmatched -= b.line.unmatched;
+        return m;
+    }
+
+    // Clear the latency histograms (counters keep running, as counters do).
+    void reset_metrics() {
+        for (auto& h : command_latency_) h.reset();
+        for (auto& h : init_latency_) h.reset();
+        txn_latency_.reset();
+        settle_latency_.reset();
+    }
+
+    // Prometheus text exposition of a snapshot: latencies as summaries in microseconds,
+    // the rest as counters. labels, if given, go into every sample (e.g. arm="2").
+    static std::string metrics_text(const metrics_report& m, const std::string& labels = std::string()) {
+        std::string out;
+        const std::string extra = labels.empty() ? std::string() : "," + labels;
+        const std::string only = labels.empty() ? std::string() : "{" + labels + "}";
+        auto summary = [&](const std::string& name, const std::string& help, const std::string& sel,
+                           const latency_histogram::summary& h) {
+            if (!help.empty()) {
+                out += "# HELP " + name + " " + help + "\n";
+                out += "# TYPE " + name + " summary\n";
+            }
+            if (h.samples == 0) return;
+            const std::pair<const char*, std::chrono::microseconds> qs[] = {
+                {"0.5", h.p50}, {"0.9", h.p90}, {"0.99", h.p99}, {"0.999", h.p999}, {"1", h.max}};
+            const std::string sep = sel.empty() ? "" : sel + ",";
+            for (const auto& q : qs)
+                out += name + "{" + sep + "quantile=\"" + q.first + "\"" + extra + "} " + std::to_string(q.second.count()) + "\n";
+            const std::string lbl = sel.empty() ? only : "{" + sel + extra + "}";
+            out += name + "_sum" + lbl + " " + std::to_string(h.total.count()) + "\n";
+            out += name + "_count" + lbl + " " + std::to_string(h.samples) + "\n";
+        };
+        for (std::size_t i = 0; i < k_wire_ops; ++i)
+            summary("act_command_latency_us", i == 0 ? "Bus time of one command, by API call." : "",
+                    std::string("op=\"") + wire_op_name(static_cast<wire_op>(i)) + "\"", m.commands[i]);
+        for (std::size_t i = 0; i < k_init_steps; ++i)
+            summary("act_command_latency_us", "", "op=\"init\",step=\"" + std::to_string(i) + "\"", m.init_steps[i]);
+        summary("act_transaction_latency_us", "One request/reply attempt, request sent to outcome.", "", m.transaction);
+        summary("act_settle_latency_us", "Blocking move, command sent to arrival seen.", "", m.settle);
+        auto counter = [&](const char* name, const char* help, uint64_t v) {
+            out += std::string("# HELP ") + name + " " + help + "\n";
+            out += std::string("# TYPE ") + name + " counter\n";
+            out += name + only + " " + std::to_string(v) + "\n";
+        };
+        counter("act_transactions_total", "Transactions started (retries not counted).", m.transactions);
+        counter("act_retries_total", "Transaction attempts repeated.", m.retries);
+        counter("act_timeouts_total", "Attempts that got no reply in time.", m.timeouts);
+        counter("act_crc_errors_total", "Attempts that ended on a corrupted reply.", m.crc_errors);
+        counter("act_exceptions_total", "Modbus exception replies.", m.exceptions);
+        counter("act_io_errors_total", "Attempts that failed on the port.", m.io_errors);
+        counter("act_connects_total", "Successful connects.", m.connects);
+        counter("act_reconnects_total", "Successful connects after the first.", m.reconnects);
+        counter("act_line_drained_bytes_total", "Stale input flushed plus bytes skipped by the parser.", m.line.drained_bytes);
+        counter("act_line_crc_errors_total", "Frame candidates rejected on CRC.", m.line.crc_errors);
+        counter("act_line_resyncs_total", "Times the parser lost frame alignment.", m.line.resyncs);
+        counter("act_line_unmatched_frames_total", "Valid frames that answered no request.", m.line.unmatched);
+        return out;
+    }
+
+    // Write metrics_text() to path for a local scraper (textfile collector), through a
+    // temporary file and a rename so a reader never sees half of it. False on I/O error.
+    bool write_metrics(const std::string& path, const std::string& labels = std::string()) const {
+        const std::string text = metrics_text(metrics_snapshot(), labels);
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::trunc);
+            if (!(f << text)) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        return !ec;
+    }
+
+    // Record this arm's serial line (all arms on it, for a shared line) to a capture file;
+    // see wire_capture. Replaces a capture already running. False if the file cannot be
+    // created or mapped.
+    bool start_capture(const std::string& path, std::size_t capacity = wire_capture::k_default_capacity) {
+        auto cap = std::make_unique<wire_capture>();
+        if (!cap->open(path, capacity, bus_->baud())) return false;
+        call_on_bus([&] { cap = bus_->set_capture(std::move(cap)); });
+        return true;
+    }
+
+    // Stop recording and close the file. Returns the counters of the capture that ran.
+    wire_capture::stats stop_capture() {
+        std::unique_ptr<wire_capture> cap;
+        call_on_bus([&] { cap = bus_->set_capture(nullptr); });
+        return cap ? cap->counters() : wire_capture::stats{};
+    }
+
+    wire_capture::stats capture_stats() {
+        wire_capture::stats out;
+        call_on_io([&] {
+            if (const wire_capture* cap = bus_->capture()) out = cap->counters();
+        });
+        return out;
+    }
+
+    // Outcome of replay_capture(). Turnaround is request sent to transaction finished.
+    struct replay_report {
+        uint64_t transactions = 0;
+        uint64_t same_outcome = 0;          // status equal to the recorded one
+        std::array<uint64_t, 5> outcomes{}; // replay results, by reply_status
+        std::chrono::microseconds recorded_p50{0};
+        std::chrono::microseconds recorded_p99{0};
+        std::chrono::microseconds replay_p50{0};
+        std::chrono::microseconds replay_p99{0};
+    };
+
+    // Send a capture's requests again, at their recorded spacing divided by speed (0: back
+    // to back), through a controller whose port plays the recorded replies back with their
+    // recorded delays (replay_transport). Each request goes through the parser, the reply
+    // matching and the deadline as it did live; retries are off, since the capture holds
+    // every attempt as a request of its own. Empty if path is not a capture.
+    static std::optional<replay_report> replay_capture(const std::string& path, double speed = 1.0) {
+        using namespace std::chrono;
+        auto cap = std::make_shared<wire_capture::reader>();
+        if (!cap->load(path)) return std::nullopt;
+        const auto& recs = cap->records();
+
+        act_controller ctrl(replayed(cap, speed));
+        transaction_policy policy = ctrl.get_transaction_policy();
+        policy.retries = 0;
+        ctrl.set_transaction_policy(policy);
+        ctrl.call_on_bus([&] { ctrl.bus_->open("replay", cap->baud() ? cap->baud() : k_default_baud); });
+
+        replay_report rep;
+        std::vector<microseconds> recorded, replayed_us;
+        const auto start = steady_clock::now();
+        nanoseconds first{-1};
+        uint8_t rx[256];
+        for (std::size_t i = 0; i < recs.size(); ++i) {
+            const wire_capture::reader::record& tx = recs[i];
+            if (tx.dir != wire_capture::kind::tx || tx.data.size() < 4) continue;
+            if (first.count() < 0) first = tx.t;
+            if (speed > 0)
+                std::this_thread::sleep_until(start + duration_cast<steady_clock::duration>((tx.t - first) / speed));
+            // Outcome recorded for this request: the first result before the next request
+            std::optional<std::size_t> result;
+            for (std::size_t j = i + 1; j < recs.size() && recs[j].dir != wire_capture::kind::tx; ++j)
+                if (recs[j].dir == wire_capture::kind::result && !recs[j].data.empty()) {
+                    result = j;
+                    break;
+                }
+
+            ctrl.slave_ = tx.data[0];
+            const auto t0 = steady_clock::now();
+            const reply_result r = ctrl.transact(tx.data.data(), tx.data.size(), rx, sizeof(rx), tx.op);
+            replayed_us.push_back(duration_cast<microseconds>(steady_clock::now() - t0));
+            ++rep.transactions;
+            ++rep.outcomes[static_cast<std::size_t>(r.status)];
+            if (result) {
+                recorded.push_back(duration_cast<microseconds>(recs[*result].t - tx.t));
+                if (recs[*result].data[0] == static_cast<uint8_t>(r.status)) ++rep.same_outcome;
+            }
+        }
+
+        auto pct = [](std::vector<microseconds>& v, double q) {
+            if (v.empty()) return microseconds(0);
+            const std::size_t k = std::min(v.size() - 1, static_cast<std::size_t>(q * static_cast<double>(v.size())));
+            std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(k), v.end());
+            return v[k];
+        };
+        rep.recorded_p50 = pct(recorded, 0.5);
+        rep.recorded_p99 = pct(recorded, 0.99);
+        rep.replay_p50 = pct(replayed_us, 0.5);
+        rep.replay_p99 = pct(replayed_us, 0.99);
+        return rep;
+    }
+
+    // Line settings for the next connect(); not while connected. Arms on a shared line
+    // use the rate their bus was opened at.
+    void set_line_settings(const line_settings& settings) {
+        if (settings.baud == 0) throw std::invalid_argument("act_controller: baud rate 0");
+        line_ = settings;
+    }
+    const line_settings& get_line_settings() const { return line_; }
+
+    // Rate of the open line.
+    unsigned get_baud_rate() const { return bus_->baud(); }
+
+    // Apply realtime_options to the calling thread.
+    static realtime_report make_thread_realtime(const realtime_options& opt, int cpu = -1) {
+        realtime_report rep;
+#ifdef __linux__
+        if (opt.priority > 0) {
+            sched_param sp{};
+            sp.sched_priority = opt.priority;
+            rep.sched_errno = ::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &sp);
+            rep.sched_fifo = rep.sched_errno == 0;
+        }
+        if (cpu >= 0 || !opt.cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (cpu >= 0) CPU_SET(cpu, &set);
+            else
+                for (int c : opt.cpus) CPU_SET(c, &set);
+            rep.affinity_errno = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+            rep.affinity = rep.affinity_errno == 0;
+        }
+        if (opt.lock_memory) {
+            rep.memory_locked = ::mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+            if (!rep.memory_locked) rep.lock_errno = errno;
+        }
+        if (opt.timer_slack_ns >= 0) {
+            rep.timer_slack = ::prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(std::max(1L, opt.timer_slack_ns)), 0, 0, 0) == 0;
+            if (!rep.timer_slack) rep.slack_errno = errno;
+        }
 #else
-            const std::string preferred = had_user ? user_com_port : std::string("/dev/ttyUSB0");
+        (void)opt;
+        (void)cpu;
 #endif
-            open_and_configure(preferred);
+        return rep;
+    }
 
-            // Probe to ensure it's responsive
-            std::vector<uint8_t> probe = hex_to_bytes("01 03 90 00 00 10 69 06");
-            write_frame(probe);
-            auto rx = read_modbus_response();
-            if (rx && validate_crc(*rx)) {
-                // Same initialization sequence as below
-                {
-                    const std::string human_cmd = "01 03 00 0e 00 08 25 cf";
-                    const auto cmd_bytes = hex_to_bytes(human_cmd);
-                    asio::write(port_, asio::buffer(cmd_bytes.data(), cmd_bytes.size()));
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-                {
-                    const std::string human_cmd2 = "01 03 00 52 00 02 65 da";
-                    const auto cmd_bytes2 = hex_to_bytes(human_cmd2);
-                    asio::write(port_, asio::buffer(cmd_bytes2.data(), cmd_bytes2.size()));
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-                {
-                    auto send_hex = [&](const std::string& s) {
-                        const auto b = hex_to_bytes(s);
-                        asio::write(port_, asio::buffer(b.data(), b.size()));
-                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                    };
-                    const std::vector<std::string> seq = {
-                        "01 03 00 00 00 70 44 2e","01 03 00 70 00 70 45 f5","01 03 00 e0 00 70 45 d8",
-                        "01 03 01 50 00 30 44 33","01 03 03 80 00 40 45 96","01 03 04 00 00 70 45 1e",
-                        "01 03 04 70 00 70 44 c5","01 03 04 e0 00 70 44 e8","01 03 05 50 00 70 44 f3",
-                        "01 03 05 c0 00 70 44 de","01 03 06 30 00 70 44 a9","01 03 06 a0 00 70 44 84",
-                        "01 03 07 10 00 70 44 9f","01 03 07 80 00 70 44 b2","01 03 07 f0 00 10 45 41",
-                        "01 03 90 11 00 02 b9 0e","01 05 00 30 ff 00 8c 35","01 05 00 19 ff 00 5d fd"
-                    };
-                    for (const auto& s : seq) send_hex(s);
+    // Real-time mode for this controller's own I/O thread, which runs every transaction,
+    // frame gap and telemetry poll. Blocking calls still wait on the caller's thread;
+    // make_thread_realtime() covers that one. Arms of a pool share the pool's threads:
+    // use act_controller_pool::enable_realtime() for those.
+    realtime_report enable_realtime(const realtime_options& opt) {
+        if (!owns_bus_) throw std::logic_error("act_controller: enable_realtime on a pool arm");
+        realtime_report rep;
+        call_on_io([&] { rep = make_thread_realtime(opt); });
+        return rep;
+    }
+
+    // Wake-up lateness recorded so far (see wake_kind).
+    jitter_recorder::snapshot jitter(wake_kind kind) const { return jitter_[static_cast<int>(kind)].get(); }
+    void reset_jitter() {
+        for (auto& j : jitter_) j.reset();
+    }
+
+    // Knobs line_settings::low_latency applied when the line was opened.
+    low_latency_report get_low_latency_report() {
+        low_latency_report out;
+        call_on_io([&] { out = bus_->latency_report(); });
+        return out;
+    }
+
+    // Move the drive to another rate and continue at it. The drive's baud parameter is
+    // not in the captures (doc section 11), so the caller names the holding register
+    // and the value that selects `baud`. The value is written with 0x10. Once the drive
+    // has acknowledged it at the old rate (or sent no reply, having switched first), the
+    // port moves to `baud` and the drive is probed there. If the probe fails, the port
+    // goes back to the old rate. Returns 0 on success, 1 if the drive refused the write
+    // or answers at neither rate. Standalone controllers only, since every arm on a
+    // shared line would have to move at once.
+    int change_baud(unsigned baud, uint16_t reg, uint16_t value) {
+        if (!owns_bus_) throw std::logic_error("act_controller: change_baud on a shared line");
+        if (!connected_ || baud == 0) return 1;
+        const unsigned old = bus_->baud();
+        const auto f = modbus::write_registers(k_slave_addr, reg, std::array<uint16_t, 1>{value});
+        uint8_t rx[256];
+        const reply_result w = transact(f.data(), f.size(), rx, sizeof(rx), wire_op::line_rate);
+        if (w.status != reply_status::ok && w.status != reply_status::timeout) return 1;
+        auto probe_at = [&](unsigned rate) {
+            call_on_bus([&] {
+                bus_->set_baud(rate);
+                rtt_ = rtt_window{}; // turnaround includes the drive's per-rate timing
+            });
+            return transact(k_probe_frame.data(), k_probe_frame.size(), rx, sizeof(rx), wire_op::line_rate).status ==
+                   reply_status::ok;
+        };
+        if (probe_at(baud)) {
+            line_.baud = baud;
+            return 0;
+        }
+        std::cout << "[port-error] no reply at " << baud << " baud, back to " << old << std::endl;
+        probe_at(old);
+        return 1;
+    }
+
+    void set_absolute_mode(absolute_mode m) { absolute_mode_ = m; }
+    absolute_mode get_absolute_mode() const { return absolute_mode_; }
+
+    // What connect() does with an init step the drive does not acknowledge (timeout,
+    // exception or corrupt reply). Lenient (default): log it, count it in
+    // last_init_report(), send the remaining steps and connect anyway, as the original
+    // fire-and-forget sequence did. Strict: abort connect() with rc=1 at that step.
+    void set_strict_init(bool strict) { strict_init_ = strict; }
+    bool get_strict_init() const { return strict_init_; }
+
+    // Command frames with their runtime fields patched in, exactly as the moves send them
+    // (public so the benchmarks time the real builders).
+
+    // Relative move parameter block at 0x9102 with speed, sign word and delta patched in.
+    // Positive deltas carry 00 00 before the magnitude, negative ones ff ff (two's complement).
+    static modbus::frame<41> relative_move_frame(int magnitude, int spd) {
+        auto command = k_relative_move_frame;
+        command.set_u16_pair(modbus::write_register_offset(1), static_cast<uint16_t>(spd),
+                             modbus::write_register_offset(2), static_cast<uint16_t>(magnitude > 0 ? 0x0000 : 0xFFFF));
+        command.set_u16(modbus::write_register_offset(3), static_cast<uint16_t>(magnitude * 100));
+        return command;
+    }
+
+    // Fast absolute move parameters: one write of speed, zero and position to 0x0411..0x0413.
+    // 01 10 04 11 00 03 06 <speed_hi> <speed_lo> 00 00 <pos_hi> <pos_lo> CRC(lo,hi)
+    static modbus::frame<15> absolute_params_frame(int position, int speed) {
+        auto frame = k_abs_params_frame;
+        frame.set_u16(modbus::write_register_offset(0), static_cast<uint16_t>(std::max(1, speed)));
+        frame.set_u16(modbus::write_register_offset(2), static_cast<uint16_t>(absolute_scaled(position)));
+        return frame;
+    }
+
+    // Modbus RTU t3.5: silence that separates two frames. Fixed at 1.75 ms above 19200 baud
+    // (spec), otherwise 3.5 character times of 11 bits each (about 4010 us at 9600).
+    static std::chrono::microseconds inter_frame_gap(unsigned baud) {
+        if (baud > 19200) return std::chrono::microseconds(1750);
+        return std::chrono::microseconds(38500000LL / baud);
+    }
+
+private:
+    // Drive an io_context until it runs out of work; a throwing handler is logged and
+    // the loop resumes, so one bad handler cannot stop every arm on the thread.
+    static void run_io(asio::io_context& io) {
+        for (;;) {
+            try {
+                io.run();
+                return;
+            } catch (const std::exception& e) {
+                std::cout << "[io-error] " << e.what() << std::endl;
+            }
+        }
+    }
+
+    asio::io_context& io() { return bus_->io(); }
+
+    // A synchronous call from the I/O thread would wait for itself forever.
+    void require_caller_thread() {
+        if (io().get_executor().running_in_this_thread())
+            throw std::logic_error("act_controller: synchronous call on its own I/O thread");
+    }
+
+    // Queue a command on this arm's queue (any thread). It runs on the I/O thread once
+    // the arm's previous command called finish_command(); op tags its frames in captures.
+    void post_job(wire_op op, bus_job job) {
+        if (op == wire_op::move_relative || op == wire_op::move_absolute || op == wire_op::trajectory ||
+            op == wire_op::reset)
+            known_position_.store(k_position_unknown, std::memory_order_relaxed);
+        bus_->submit(client_, [this, op, j = std::move(job)]() mutable {
+            op_ = op;
+            command_start_ = std::chrono::steady_clock::now();
+            j();
+        });
+    }
+
+    void finish_command() {
+        const auto t = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - command_start_);
+        if (op_ == wire_op::init) init_latency_[init_step_].record(t);
+        else command_latency_[static_cast<std::size_t>(op_)].record(t);
+        bus_->finish_command(client_);
+    }
+
+    // Command step: one request/reply with this arm's slave in the next fair bus slot,
+    // bounded and retried as transaction_policy says. Every attempt takes its own slot,
+    // so other arms on the line get the bus between retries. req must stay valid until
+    // done runs.
+    void bus_transact(const uint8_t* req, std::size_t len, uint8_t* rx, std::size_t cap,
+                      unique_callback<void(reply_result)> done, int attempt = 0) {
+        bus_->acquire(client_, [this, req, len, rx, cap, attempt, d = std::move(done)]() mutable {
+            const transaction_policy policy = get_transaction_policy();
+            const unsigned baud = bus_->baud();
+            const auto timeout = wire_time(len + max_reply_length(req), baud) + turnaround_allowance(policy, attempt == 0);
+            const auto t0 = std::chrono::steady_clock::now();
+            if (attempt == 0) txn_count_.fetch_add(1, std::memory_order_relaxed);
+            bus_->transact(slave_, op_, req, len, rx, cap, timeout,
+                [this, req, len, rx, cap, attempt, retries = policy.retries, baud, t0, d = std::move(d)](reply_result r) mutable {
+                    bus_->release();
+                    txn_latency_.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0));
+                    if (r.status == reply_status::crc_error) txn_crc_errors_.fetch_add(1, std::memory_order_relaxed);
+                    else if (r.status == reply_status::exception) txn_exceptions_.fetch_add(1, std::memory_order_relaxed);
+                    else if (r.status == reply_status::io_error) txn_io_errors_.fetch_add(1, std::memory_order_relaxed);
+                    if (r.status == reply_status::ok || r.status == reply_status::exception) {
+                        const std::size_t reply_len = r.status == reply_status::ok ? r.len : 5;
+                        rtt_.add(std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now() - t0) - wire_time(len + reply_len, baud));
+                    } else if (r.status == reply_status::timeout || r.status == reply_status::crc_error) {
+                        if (r.status == reply_status::timeout) txn_timeouts_.fetch_add(1, std::memory_order_relaxed);
+                        if (attempt < retries && retry_safe(req)) {
+                            txn_retries_.fetch_add(1, std::memory_order_relaxed);
+                            bus_transact(req, len, rx, cap, std::move(d), attempt + 1);
+                            return;
+                        }
+                    }
+                    d(r);
+                });
+        });
+    }
+
+    // Turnaround allowed to one attempt; see transaction_policy. I/O thread.
+    std::chrono::microseconds turnaround_allowance(const transaction_policy& p, bool first) const {
+        const std::chrono::microseconds hi = p.max_turnaround;
+        if (!first || rtt_.count() < k_rtt_min_samples) return hi;
+        const double us = static_cast<double>(rtt_.percentile(0.99).count()) * p.rtt_factor;
+        const std::chrono::microseconds t(std::llround(us));
+        return std::clamp<std::chrono::microseconds>(t, p.min_turnaround, hi);
+    }
+
+    // Requests that may go out again when their reply was lost. Register and coil writes
+    // just store the same value twice; a second relative move trigger would move again.
+    static bool retry_safe(const uint8_t* req) {
+        return !(req[1] == 0x10 && req[2] == 0x91 && req[3] == 0x00);
+    }
+
+    // Run f on the I/O thread and wait; exceptions are rethrown in the caller.
+    template <typename F>
+    void call_on_io(F f) {
+        require_caller_thread();
+        sync_waiter w;
+        std::exception_ptr err;
+        asio::post(io(), [&] {
+            try { f(); } catch (...) { err = std::current_exception(); }
+            w.signal();
+        });
+        w.wait();
+        if (err) std::rethrow_exception(err);
+    }
+
+    // Same, but as a command holding a bus slot: open/close never overlap a transaction.
+    template <typename F>
+    void call_on_bus(F f) {
+        require_caller_thread();
+        sync_waiter w;
+        std::exception_ptr err;
+        post_job(wire_op::other, [&] {
+            bus_->acquire(client_, [&] {
+                try { f(); } catch (...) { err = std::current_exception(); }
+                bus_->release();
+                finish_command();
+                w.signal();
+            });
+        });
+        w.wait();
+        if (err) std::rethrow_exception(err);
+    }
+
+    // Start an async op that completes with void(asio::error_code) and block until it has.
+    template <typename Start>
+    asio::error_code wait_sync(Start&& start) {
+        require_caller_thread();
+        sync_waiter w;
+        asio::error_code out;
+        start([&](const asio::error_code& ec) {
+            out = ec;
+            w.signal();
+        });
+        w.wait();
+        return out;
+    }
+
+    // Deliver an async result on the handler's executor; inline when that is the I/O
+    // thread, as for plain callbacks.
+    template <typename Handler, typename... Args>
+    void complete(Handler&& h, Args&&... args) {
+        auto ex = asio::get_associated_executor(h, io().get_executor());
+        asio::dispatch(ex, pooled([h = std::forward<Handler>(h), a = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            std::apply(h, std::move(a));
+        }));
+    }
+
+    // Queue a command batch as one command. The handler's executor is kept busy until the
+    // result is delivered, so a coroutine's io_context does not run out of work meanwhile.
+    template <typename CompletionToken>
+    async_result_t<CompletionToken, void(asio::error_code)>
+    async_run_batch(const command_batch& batch, CompletionToken&& token) {
+        return asio::async_initiate<CompletionToken, void(asio::error_code)>(
+            [this](auto handler, const command_batch& b) {
+                auto work = asio::make_work_guard(asio::get_associated_executor(handler, io().get_executor()));
+                if (b.count == 0) { // nothing to send (zero-length move)
+                    asio::post(io(), pooled([this, h = std::move(handler), w = std::move(work)]() mutable {
+                        complete(std::move(h), asio::error_code());
+                    }));
+                    return;
                 }
-                {
-                    char response_buffer[128];
-                    asio::error_code ec;
-                    std::size_t bytes_read = port_.read_some(asio::buffer(response_buffer), ec);
-                    (void)bytes_read;
+                post_job(b.op, [this, b, h = std::move(handler), w = std::move(work)]() mutable {
+                    batch_ = b;
+                    run_batch(0, [this, h = std::move(h), w = std::move(w)](asio::error_code ec) mutable {
+                        finish_command();
+                        complete(std::move(h), ec);
+                    });
+                });
+            },
+            token, batch);
+    }
+
+    // Command body: send each frame of batch_ as a transaction in its own bus slot, the
+    // next one batch_.pause after the previous reply (the vendor pacing). Replies are
+    // matched to their requests, so there are no acks left to drain afterwards. Pauses
+    // do not hold the bus, so other arms on the line keep going.
+    void run_batch(std::size_t i, unique_callback<void(asio::error_code)> done) {
+        if (i == batch_.count) {
+            done(asio::error_code());
+            return;
+        }
+        const uint8_t* f = batch_.frames[i].data();
+        bus_transact(f, batch_.lens[i], job_rx_, sizeof(job_rx_),
+            [this, i, d = std::move(done)](reply_result r) mutable {
+                if (r.status != reply_status::ok) {
+                    d(r.status == reply_status::io_error && !bus_->is_open()
+                          ? asio::error_code(asio::error::not_connected) : make_error_code(r.status));
+                    return;
                 }
-                connected_ = true;
-                port_name_ = preferred;
-                if (had_user && preferred != requested) {
-                    std::cout << "[port-info] Requested " << requested << " connected as " << preferred << std::endl;
+                if (i + 1 == batch_.count || batch_.pause.count() == 0) {
+                    run_batch(i + 1, std::move(d));
+                    return;
                 }
-                return 0;
-            }
-        } catch (...) {
-            safe_close();
-            connected_ = false;
-            port_name_.clear();
-            // fall through to the existing scan below
+                pause_timer_.expires_after(batch_.pause);
+                pause_timer_.async_wait(pooled([this, i, d = std::move(d)](const asio::error_code&) mutable {
+                    note_wake(wake_kind::command, pause_timer_.expiry());
+                    run_batch(i + 1, std::move(d));
+                }));
+            });
+    }
+
+    // Trajectory in progress on this arm (I/O thread only; the command holds the arm).
+    struct trajectory_run {
+        std::vector<waypoint> points;
+        trajectory_options opt;
+        std::vector<segment_result> results;
+        std::size_t seg = 0;
+        bool next_loaded = false; // points[seg] parameters already written
+        std::chrono::steady_clock::time_point t0;
+        std::chrono::steady_clock::time_point deadline;
+        unique_callback<void(asio::error_code)> done;
+    };
+
+    void start_trajectory(std::vector<waypoint> points, const trajectory_options& opt,
+                          unique_callback<void(asio::error_code)> done) {
+        traj_.points = std::move(points);
+        traj_.opt = opt;
+        traj_.results.clear();
+        traj_.seg = 0;
+        traj_.next_loaded = false;
+        traj_.t0 = std::chrono::steady_clock::now();
+        traj_.done = std::move(done);
+        start_segment();
+    }
+
+    void finish_trajectory(asio::error_code ec) {
+        auto done = std::move(traj_.done);
+        done(ec);
+    }
+
+    std::chrono::microseconds trajectory_time() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - traj_.t0);
+    }
+
+    // Load (unless preloaded) and trigger points[seg], then preload points[seg + 1].
+    void start_segment() {
+        if (traj_.seg == traj_.points.size()) {
+            finish_trajectory(asio::error_code());
+            return;
         }
-        if (connected_) return 0;
-        try {
-            // Scan for responsive COM ports
-            const std::vector<std::string> candidates = make_port_list();
-            std::string name;
-            for (const auto& cand : candidates) {
-                try {
-                    open_and_configure(cand);
-                    std::vector<uint8_t> probe = hex_to_bytes("01 03 90 00 00 10 69 06");
-                    write_frame(probe);
-                    auto rx = read_modbus_response();
-                    if (rx && validate_crc(*rx)) { name = cand; break; }
-                } catch (...) {
-                    // ignore
-                }
-                safe_close();
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
-            }
-            if (name.empty()) {
-                if (had_user)
-                    std::cout << "[port-error] Requested " << requested << " not found or unresponsive." << std::endl;
-                return 1;
+        const waypoint& wp = traj_.points[traj_.seg];
+        segment_result r;
+        r.commanded = (absolute_scaled(wp.position) + 50) / 100;
+        r.preloaded = traj_.next_loaded;
+        traj_.results.push_back(r);
+
+        const absolute_mode mode = absolute_mode_;
+        batch_ = traj_.next_loaded ? command_batch() : absolute_params_batch(wp.position, wp.speed, mode);
+        if (mode == absolute_mode::fast) add_absolute_start(batch_);
+        else for (const auto& f : k_abs_start_frames) batch_.add(f);
+        run_acked(0, [this, mode](asio::error_code ec) {
+            segment_result& cur = traj_.results.back();
+            if (ec == make_error_code(reply_status::exception) && mode == absolute_mode::fast) {
+                // Refused fast frames: switch to legacy and send this segment again
+                absolute_mode_ = absolute_mode::legacy;
+                traj_.results.pop_back();
+                traj_.next_loaded = false;
+                start_segment();
+                return;
             }
-            if (had_user && name != requested) {
-                std::cout << "[port-info] Requested " << requested << " not responsive, using " << name << std::endl;
+            if (ec) {
+                cur.error = ec;
+                finish_trajectory(ec);
+                return;
             }
-            // ...existing initialization sequence (same as above)...
-            {
-                const std::string human_cmd = "01 03 00 0e 00 08 25 cf";
-                const auto cmd_bytes = hex_to_bytes(human_cmd);
-                asio::write(port_, asio::buffer(cmd_bytes.data(), cmd_bytes.size()));
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            coil_1a_off_ = true;
+            cur.triggered = trajectory_time();
+            traj_.deadline = std::chrono::steady_clock::now() + traj_.opt.segment_timeout;
+            traj_.next_loaded = false;
+            if (!traj_.opt.lookahead || traj_.seg + 1 == traj_.points.size()) {
+                poll_segment();
+                return;
             }
+            const waypoint& next = traj_.points[traj_.seg + 1];
+            batch_ = absolute_params_batch(next.position, next.speed, absolute_mode_);
+            run_acked(0, [this](asio::error_code pec) {
+                traj_.next_loaded = !pec; // refused: load it after arrival instead
+                poll_segment();
+            });
+        });
+    }
 
-            // Send another human-readable hex command right after the last human_cmd
-            {
-                const std::string human_cmd2 = "01 03 00 52 00 02 65 da";
-                const auto cmd_bytes2 = hex_to_bytes(human_cmd2);
-                asio::write(port_, asio::buffer(cmd_bytes2.data(), cmd_bytes2.size()));
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Read the position until points[seg] is within tolerance, then dwell and move on.
+    void poll_segment() {
+        read_status_regs([this](asio::error_code ec, uint16_t status, int16_t raw) {
+            segment_result& cur = traj_.results.back();
+            const auto now = std::chrono::steady_clock::now();
+            if (!ec) {
+                publish_sample(raw, status, now);
+                cur.reached = scale_position(raw);
+                // The flag can still be set from the previous segment right after the start
+                // pulse; settled() also wants the new target within tolerance
+                if (settled(decode_status(status, raw, now), cur.commanded, traj_.opt.tolerance)) {
+                    cur.arrived = true;
+                    cur.in_position = trajectory_time();
+                    pause_timer_.expires_after(traj_.points[traj_.seg].dwell);
+                    pause_timer_.async_wait(pooled([this](const asio::error_code&) {
+                        note_wake(wake_kind::command, pause_timer_.expiry());
+                        ++traj_.seg;
+                        start_segment();
+                    }));
+                    return;
+                }
+            } else if (ec == asio::error::not_connected) {
+                cur.error = ec;
+                finish_trajectory(ec);
+                return;
             }
-
-            // Send a batch of additional human-readable hex commands
-            {
-                auto send_hex = [&](const std::string& s) {
-                    const auto b = hex_to_bytes(s);
-                    asio::write(port_, asio::buffer(b.data(), b.size()));
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                };
-                const std::vector<std::string> seq = {
-                    "01 03 00 00 00 70 44 2e","01 03 00 70 00 70 45 f5","01 03 00 e0 00 70 45 d8",
-                    "01 03 01 50 00 30 44 33","01 03 03 80 00 40 45 96","01 03 04 00 00 70 45 1e",
-                    "01 03 04 70 00 70 44 c5","01 03 04 e0 00 70 44 e8","01 03 05 50 00 70 44 f3",
-                    "01 03 05 c0 00 70 44 de","01 03 06 30 00 70 44 a9","01 03 06 a0 00 70 44 84",
-                    "01 03 07 10 00 70 44 9f","01 03 07 80 00 70 44 b2","01 03 07 f0 00 10 45 41",
-                    "01 03 90 11 00 02 b9 0e","01 05 00 30 ff 00 8c 35","01 05 00 19 ff 00 5d fd"
-                };
-                for (const auto& s : seq) send_hex(s);
-            }
-
-            // Read a short response
-            {
-                char response_buffer[128];
-                asio::error_code ec;
-                (void)port_.read_some(asio::buffer(response_buffer), ec);
+            if (now >= traj_.deadline) {
+                cur.error = ec ? ec : asio::error_code(asio::error::timed_out);
+                finish_trajectory(cur.error);
+                return;
             }
-            connected_ = true;
-            port_name_ = name;
-            return 0;
-        } catch (...) {
-            safe_close();
-            connected_ = false;
-            port_name_.clear();
-            return 1;
-        }
+            pause_timer_.expires_after(traj_.opt.poll);
+            pause_timer_.async_wait(pooled([this](const asio::error_code&) {
+                note_wake(wake_kind::poll, pause_timer_.expiry());
+                poll_segment();
+            }));
+        });
     }
-        // Reset controller (reverse engineered)
-    void reset() {
-        if (!connected_) return;
-        const std::vector<std::string> seq = {
-            // "01 03 00 0e 00 08 25 cf",
-            // "01 03 00 52 00 02 65 da",
-            // "01 03 00 00 00 70 44 2e",
-            // "01 03 00 70 00 70 45 f5",
-            // "01 03 00 e0 00 70 45 d8",
-            // "01 03 01 50 00 30 44 33",
-            // "01 03 03 80 00 40 45 96",
-            // "01 03 04 00 00 70 45 1e",
-            // "01 03 04 70 00 70 44 c5",
-            // "01 03 04 e0 00 70 44 e8",
-            // "01 03 05 50 00 70 44 f3",
-            // "01 03 05 c0 00 70 44 de",
-            // "01 03 06 30 00 70 44 a9",
-            // "01 03 06 a0 00 70 44 84",
-            // "01 03 07 10 00 70 44 9f",
-            // "01 03 07 80 00 70 44 b2",
-            // "01 03 07 f0 00 10 45 41",
-            // "01 03 90 11 00 02 b9 0e",
-            // repeated probe frames
-            // "01 03 03 80 00 40 45 96","01 03 03 80 00 40 45 96","01 03 03 80 00 40 45 96",
-            // "01 03 03 80 00 40 45 96","01 03 03 80 00 40 45 96","01 03 03 80 00 40 45 96",
-            // "01 03 03 80 00 40 45 96","01 03 03 80 00 40 45 96","01 03 03 80 00 40 45 96",
-            "01 03 03 80 00 40 45 96",
-            // reset command
-            "01 05 00 45 ff 00 9d ef",
-            // final probe
-            // "01 03 03 80 00 40 45 96",
-            "01 05 00 1c ff 00 4d fc", // added
-            "01 05 00 1c 00 00 0c 0c"  // added
-        };
-        for (const auto& s : seq) {
-            const auto frame = hex_to_bytes(s);
-            asio::write(port_, asio::buffer(frame.data(), frame.size()));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // run_batch without the vendor pacing: each frame goes out as soon as the previous
+    // one is acknowledged.
+    void run_acked(std::size_t i, unique_callback<void(asio::error_code)> done) {
+        batch_.pause = std::chrono::milliseconds(0);
+        run_batch(i, std::move(done));
+    }
+
+    // Command body of an absolute move. Fast mode runs acknowledged; an exception reply
+    // to any of its frames means the controller does not take that form, so the move is
+    // redone with the legacy sequence and later moves use it directly.
+    void run_absolute(int position, int speed, unique_callback<void(asio::error_code)> done) {
+        if (absolute_mode_ == absolute_mode::legacy) {
+            batch_ = absolute_move_batch(position, speed);
+            run_batch(0, [this, d = std::move(done)](asio::error_code ec) mutable {
+                if (!ec) coil_1a_off_ = true;
+                d(ec);
+            });
+            return;
         }
-        // consume any trailing acks
-        asio::steady_timer timer(io_);
-        unsigned char buf[32];
-        timer.expires_after(std::chrono::milliseconds(150));
-        timer.async_wait([&](const asio::error_code&){ port_.cancel(); });
-        port_.async_read_some(asio::buffer(buf, sizeof(buf)),
-            [&](const asio::error_code&, std::size_t){});
-        io_.run();
-        io_.restart();
+        batch_ = absolute_params_batch(position, speed, absolute_mode::fast);
+        add_absolute_start(batch_);
+        run_acked(0, [this, position, speed, d = std::move(done)](asio::error_code ec) mutable {
+            if (ec == make_error_code(reply_status::exception)) {
+                absolute_mode_ = absolute_mode::legacy;
+                run_absolute(position, speed, std::move(d));
+                return;
+            }
+            if (!ec) coil_1a_off_ = true;
+            d(ec);
+        });
     }
 
+    // Fast-mode start pulse. Every move leaves coil 0x001A OFF, so the leading OFF of the
+    // captured sequence is only sent while its state is unknown (first move after connect).
+    void add_absolute_start(command_batch& b) const {
+        if (!coil_1a_off_) b.add(k_coil_1a_off_frame);
+        for (const auto& f : k_abs_fast_start_frames) b.add(f);
+    }
 
-    // Close the serial connection if open.
-    void disconnect() {
-        safe_close();
-        connected_ = false;
-        port_name_.clear();
+    static command_batch relative_move_batch(int magnitude, int spd) {
+        command_batch b;
+        b.op = wire_op::move_relative;
+        // Parameter block: only speed, sign word and delta are patched into the constant frame
+        b.add(relative_move_frame(magnitude, spd));
+        b.add(k_relative_trigger_frame);
+        // Negative case: controller_minus flow sends the coil tail last
+        if (magnitude < 0) b.add(k_coil_1a_off_frame);
+        return b;
     }
 
-    // Move to origin (placeholder - no specific origin command known; implement when available).
-    // For now, just move to absolute position 0.
-    void move_to_origin() {
-        move_absolute(0);
+    // External units -> device units for an absolute target, clamped to the 16-bit register.
+    static int absolute_scaled(int position) {
+        int scaled = position * 100;
+        if (scaled < 0) scaled = 0;
+        if (scaled > 0xFFFF) scaled = 0xFFFF;
+        return scaled;
     }
 
-    // Move relative by magnitude (positive or negative).
-    void move_relative(int magnitude, [[maybe_unused]] int move_speed /* [1..30] */ = 10) {
-        if (!connected_ || magnitude == 0) return;
-        int spd = move_speed;
-        if (spd < 1) spd = 1;
-        else if (spd > 30) spd = 30;
-        // std::cout << "Speed: " << spd << '\n';
-
-        // Big-endian bytes to use in command frames
-        unsigned char speed_hi = static_cast<unsigned char>((spd >> 8) & 0xFF);
-        unsigned char speed_lo = static_cast<unsigned char>(spd & 0xFF);
-        // std::cout << "Speed bytes (hi, lo): 0x" << std::hex
-        //       << static_cast<int>(speed_hi) << " 0x" << static_cast<int>(speed_lo)
-        //       << std::dec << '\n';
-        // Compute hex bytes (big-endian) for use in command array
-        if (magnitude > 0) {
-            uint16_t val = static_cast<uint16_t>(magnitude * 100);
-            unsigned char hi = static_cast<unsigned char>((val >> 8) & 0xFF);
-            unsigned char lo = static_cast<unsigned char>(val & 0xFF);
-
-            // Build mutable command without trailing CRC; inject hi/lo; then append computed CRC
-            std::vector<unsigned char> command = {
-                0x01, 0x10, 0x91, 0x02, 0x00, 0x10, 0x20, 0x00,
-                0x02, speed_hi, speed_lo, 0x00, 0x00, hi, lo, 0x03,
-                0xe8, 0x03, 0xe8, 0x00, 0x00, 0x00, 0x00, 0x00,
-                0x01, 0x00, 0x64, 0x00, 0x00, 0x00, 0x00, 0x00,
-                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32
-            };
-            uint16_t crc = crc16_modbus(command.data(), command.size());
-            command.push_back(static_cast<unsigned char>(crc & 0xFF));        // CRC low
-            command.push_back(static_cast<unsigned char>((crc >> 8) & 0xFF)); // CRC high
+    static command_batch absolute_move_batch(int position, int speed) {
+        command_batch b = absolute_params_batch(position, speed, absolute_mode::legacy);
+        // Additional command sequence (same as controller_absolute_movement)
+        for (const auto& f : k_abs_start_frames) b.add(f);
+        return b;
+    }
 
-            asio::write(port_, asio::buffer(command.data(), command.size()));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Speed (0x0411) and position (0x0412) frames of an absolute move, without the start pulse.
+    static command_batch absolute_params_batch(int position, int speed, absolute_mode mode) {
+        // clamp speed
+        if (speed < 1) speed = 1;
+        // else if (speed > 30) speed = 30;
+        const int scaled = absolute_scaled(position);
 
-            const unsigned char trigger[] = {0x01, 0x10, 0x91, 0x00, 0x00, 0x01, 0x02, 0x01, 0x00, 0x27, 0x09};
-            asio::write(port_, asio::buffer(trigger, sizeof(trigger)));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        } else {
-            // Negative case: copy controller_minus flow (ff ff hi lo, CRC, trigger, then tail last)
-            uint16_t val = static_cast<uint16_t>(magnitude * 100); // two's complement
-            unsigned char hi = static_cast<unsigned char>((val >> 8) & 0xFF);
-            unsigned char lo = static_cast<unsigned char>(val & 0xFF);
-
-            std::vector<unsigned char> command = {
-                0x01, 0x10, 0x91, 0x02, 0x00, 0x10, 0x20, 0x00,
-                0x02, speed_hi, speed_lo, 0xFF, 0xFF, hi, lo, 0x03,
-                0xE8, 0x03, 0xE8, 0x00, 0x00, 0x00, 0x00, 0x00,
-                0x01, 0x00, 0x64, 0x00, 0x00, 0x00, 0x00, 0x00,
-                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32
-            };
-            uint16_t crc = crc16_modbus(command.data(), command.size());
-            command.push_back(static_cast<unsigned char>(crc & 0xFF));        // CRC low
-            command.push_back(static_cast<unsigned char>((crc >> 8) & 0xFF)); // CRC high
+        command_batch b;
+        b.op = wire_op::move_absolute;
+        if (mode == absolute_mode::fast) {
+            b.add(absolute_params_frame(position, speed));
+            return b;
+        }
+        // speed frame: 01 10 04 11 00 01 02 <speed_hi> <speed_lo> CRC(lo,hi)
+        auto speed_frame = k_abs_speed_frame;
+        speed_frame.set_u16(modbus::write_register_offset(0), static_cast<uint16_t>(speed));
+        b.add(speed_frame);
+        // position frame: 01 10 04 12 00 02 04 00 00 <pos_hi> <pos_lo> CRC(lo,hi)
+        auto frame = k_abs_position_frame;
+        frame.set_u16(modbus::write_register_offset(1), static_cast<uint16_t>(scaled));
+        b.add(frame);
+        return b;
+    }
 
-            asio::write(port_, asio::buffer(command.data(), command.size()));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Helpers
+    static std::vector<std::string> make_port_list() {
+#ifdef _WIN32
+        std::vector<std::string> ports;
+        for (int i = 1; i <= 32; ++i) ports.push_back("COM" + std::to_string(i));
+        return ports;
+#else
+        std::vector<std::string> ports;
+        for (int i = 0; i < 10; ++i) ports.push_back("/dev/ttyUSB" + std::to_string(i));
+        for (int i = 0; i < 32; ++i) ports.push_back("/dev/ttyS" + std::to_string(i));
+        for (int i = 0; i < 64; ++i) ports.push_back("/dev/tty" + std::to_string(i));
 
-            const unsigned char trigger[] = {0x01, 0x10, 0x91, 0x00, 0x00, 0x01, 0x02, 0x01, 0x00, 0x27, 0x09};
-            asio::write(port_, asio::buffer(trigger, sizeof(trigger)));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        return ports;
+#endif
+    }
 
-            const unsigned char tail[] = {0x01, 0x05, 0x00, 0x1a, 0x00, 0x00, 0xec, 0x0d};
-            asio::write(port_, asio::buffer(tail, sizeof(tail)));  // send this last
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
+#ifdef __linux__
+    static std::string read_sysfs(const std::filesystem::path& p) {
+        std::ifstream in(p);
+        std::string v;
+        std::getline(in, v);
+        while (!v.empty() && (v.back() == '\n' || v.back() == ' ')) v.pop_back();
+        return v;
+    }
+#endif
+
+    // Default cache location: $XDG_CACHE_HOME or ~/.cache (LOCALAPPDATA on Windows).
+    static std::string default_port_cache_path() {
+#ifdef _WIN32
+        const char* base = std::getenv("LOCALAPPDATA");
+        if (!base || !*base) return std::string();
+        return std::string(base) + "\\act_controller\\last_port";
+#else
+        if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+            return std::string(xdg) + "/act_controller/last_port";
+        const char* home = std::getenv("HOME");
+        if (!home || !*home) return std::string();
+        return std::string(home) + "/.cache/act_controller/last_port";
+#endif
+    }
 
-        // Timed, non-blocking read to avoid hanging (unchanged)
-        std::vector<unsigned char> rb; rb.reserve(32);
-        asio::steady_timer timer(io_);
-        bool data_received = false;
-        asio::error_code ec;
+    // Persist the fingerprint of a port that just answered the probe and finished init.
+    void remember_port(const std::string& device) {
+        port_fingerprint fp;
+        fp.device = device;
+        std::error_code ec;
+        const std::string real = std::filesystem::exists(device, ec)
+                                     ? std::filesystem::canonical(device, ec).string() : device;
+        for (const auto& pi : enumerate_ports()) {
+            if (pi.device == device || pi.device == real) {
+                fp.adapter_serial = pi.serial;
+                fp.vid = pi.vid;
+                fp.pid = pi.pid;
+            }
+        }
+        save_port_fingerprint(port_cache_path_, fp);
+    }
 
-        unsigned char buf[32];
-        std::size_t n = 0;
+    void open_and_configure(const std::string& name, unsigned baud) { bus_->open(name, baud, line_.low_latency); }
 
-        timer.expires_after(std::chrono::milliseconds(300));
-        timer.async_wait([&](const asio::error_code&){ port_.cancel(); });
+    static void configure(asio::serial_port& port, unsigned baud) {
+        port.set_option(asio::serial_port_base::baud_rate(baud));
+        port.set_option(asio::serial_port_base::character_size(8));
+        port.set_option(asio::serial_port_base::parity(asio::serial_port_base::parity::none));
+        port.set_option(asio::serial_port_base::stop_bits(asio::serial_port_base::stop_bits::one));
+        port.set_option(asio::serial_port_base::flow_control(asio::serial_port_base::flow_control::none));
+    }
 
-        port_.async_read_some(asio::buffer(buf, sizeof(buf)), [&](const asio::error_code& error, std::size_t bytes_transferred) {
-            if (!error && bytes_transferred > 0) {
-                rb.insert(rb.end(), buf, buf + bytes_transferred);
-                data_received = true;
+    // Linux low-latency knobs for the reply path:
+    // - ASYNC_LOW_LATENCY: the driver hands received bytes to the tty at once instead
+    //   of from deferred work.
+    // - VMIN 1 / VTIME 0: asio reads are non-blocking, and the tty only reports input
+    //   once VMIN bytes are in (VTIME adds a 100 ms-granular timer), so the port becomes
+    //   readable on the first byte of a reply; the RTU parser assembles the frame.
+    //   A frame-sized VMIN would stall on shorter replies and exception frames.
+    // - USB latency timer: FTDI-style adapters hold received bytes up to this long
+    //   (16 ms by default) before sending them over USB. Lowered to 1 ms when the sysfs
+    //   file is writable; timer_path is set to it so close() can restore it.
+    static low_latency_report tune_low_latency(asio::serial_port& port, const std::string& name,
+                                               std::string& timer_path) {
+        low_latency_report rep;
+        rep.requested = true;
+#ifdef __linux__
+        const int fd = port.native_handle();
+        serial_struct ss{};
+        if (::ioctl(fd, TIOCGSERIAL, &ss) == 0) {
+            ss.flags |= ASYNC_LOW_LATENCY;
+            rep.async_low_latency = ::ioctl(fd, TIOCSSERIAL, &ss) == 0;
+        }
+        termios tio{};
+        if (::tcgetattr(fd, &tio) == 0) {
+            tio.c_cc[VMIN] = 1;
+            tio.c_cc[VTIME] = 0;
+            rep.vmin_vtime = ::tcsetattr(fd, TCSANOW, &tio) == 0;
+        }
+        std::error_code ec;
+        const std::filesystem::path dev = std::filesystem::canonical(name, ec);
+        if (!ec) {
+            const std::filesystem::path timer =
+                std::filesystem::path("/sys/class/tty") / dev.filename() / "device" / "latency_timer";
+            const std::string was = read_sysfs(timer);
+            if (!was.empty()) {
+                rep.latency_timer_was_ms = std::atoi(was.c_str());
+                if (rep.latency_timer_was_ms > 1 && write_sysfs(timer.string(), 1)) timer_path = timer.string();
+                rep.latency_timer_ms = std::atoi(read_sysfs(timer).c_str());
             }
-        });
-
-        io_.run();
-        io_.restart();
+        }
+#else
+        (void)port;
+        (void)name;
+        (void)timer_path;
+#endif
+        return rep;
     }
 
-    // Move to absolute position (units in same external unit as get_current_position()).
-    // Internally scale by 100 to device units (big-endian 16-bit).
-    void move_absolute(int position, int speed = 10) {
-        if (!connected_) return;
-        // clamp speed
-        if (speed < 1) speed = 1;
-        // else if (speed > 30) speed = 30;
-        unsigned char speed_hi = static_cast<unsigned char>((speed >> 8) & 0xFF);
-        unsigned char speed_lo = static_cast<unsigned char>(speed & 0xFF);
+    static bool write_sysfs(const std::string& path, int value) {
+#ifdef __linux__
+        std::ofstream out(path);
+        out << value << std::flush;
+        return static_cast<bool>(out);
+#else
+        (void)path;
+        (void)value;
+        return false;
+#endif
+    }
 
-        int scaled = position * 100;
-        if (scaled < 0) scaled = 0;
-        if (scaled > 0xFFFF) scaled = 0xFFFF;
-        uint16_t abs_mov_u16 = static_cast<uint16_t>(scaled);
-        unsigned char abs_hi = static_cast<unsigned char>((abs_mov_u16 >> 8) & 0xFF);
-        unsigned char abs_lo = static_cast<unsigned char>(abs_mov_u16 & 0xFF);
+    // One in-flight probe of discover(): open, write the probe frame, read until a full
+    // CRC-valid 0x03 reply or the deadline, whichever comes first.
+    struct probe_op {
+        explicit probe_op(asio::io_context& io) : port(io), timer(io) {}
+        std::string name;
+        asio::serial_port port;
+        asio::steady_timer timer;
+        uint8_t buf[256];
+        std::size_t len = 0;
+        std::chrono::steady_clock::time_point t0;
+        bool done = false;
+    };
 
-        // speed frame: 01 10 04 11 00 01 02 <speed_hi> <speed_lo> CRC(lo,hi)
-        std::vector<unsigned char> speed_frame = {
-            0x01, 0x10, 0x04, 0x11, 0x00, 0x01, 0x02, speed_hi, speed_lo
-        };
-        {
-            uint16_t crc = crc16_modbus(speed_frame.data(), speed_frame.size());
-            speed_frame.push_back(static_cast<unsigned char>(crc & 0xFF));
-            speed_frame.push_back(static_cast<unsigned char>((crc >> 8) & 0xFF));
-            asio::write(port_, asio::buffer(speed_frame.data(), speed_frame.size()));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-
-        // position frame (unchanged logic)
-        std::vector<unsigned char> frame = {
-            0x01, 0x10, 0x04, 0x12, 0x00, 0x02, 0x04, 0x00, 0x00
-        };  
-        frame.push_back(abs_hi);
-        frame.push_back(abs_lo);
-        uint16_t crc = crc16_modbus(frame.data(), frame.size());
-        frame.push_back(static_cast<unsigned char>(crc & 0xFF));
-        frame.push_back(static_cast<unsigned char>((crc >> 8) & 0xFF));
+    struct discovery_run {
+        discovery_run(asio::io_context& io_ctx, bool first, unsigned rate)
+            : io(io_ctx), first_only(first), baud(rate) {}
+        asio::io_context& io;
+        bool first_only;
+        unsigned baud;
+        std::vector<std::unique_ptr<probe_op>> ops;
+        std::vector<probe_result> results;
 
-        asio::write(port_, asio::buffer(frame.data(), frame.size()));
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        void start(const std::string& name, std::chrono::milliseconds timeout) {
+            auto op = std::make_unique<probe_op>(io);
+            op->name = name;
+            asio::error_code ec;
+            op->port.open(name, ec);
+            if (ec) return; // missing / busy device: nothing to wait for
+            try {
+                configure(op->port, baud);
+            } catch (...) {
+                return; // not a serial device (termios rejected)
+            }
+            probe_op* p = op.get();
+            ops.push_back(std::move(op));
+            p->t0 = std::chrono::steady_clock::now();
+            p->timer.expires_after(timeout);
+            p->timer.async_wait([this, p](const asio::error_code& tec) {
+                if (!tec) finish(*p, false);
+            });
+            asio::async_write(p->port, asio::buffer(k_probe_frame.data(), k_probe_frame.size()),
+                [this, p](const asio::error_code& wec, std::size_t) {
+                    if (wec) finish(*p, false);
+                    else read_more(*p);
+                });
+        }
 
-        // Additional hex command sequence (same as controller_absolute_movement)
-        {
-            auto send_hex = [&](const std::string& s) {
-                const auto b = hex_to_bytes(s);
-                asio::write(port_, asio::buffer(b.data(), b.size()));
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            };
-            const std::vector<std::string> seq = {
-                "01 05 00 1a 00 00 ec 0d",
-                "01 0f 00 10 00 08 01 01 fe 96",
-                "01 05 00 1a ff 00 ad fd",
-                "01 05 00 1a 00 00 ec 0d"
-            };
-            for (const auto& s : seq) send_hex(s);
+        void read_more(probe_op& p) {
+            if (p.done) return;
+            p.port.async_read_some(asio::buffer(p.buf + p.len, sizeof(p.buf) - p.len),
+                [this, &p](const asio::error_code& ec, std::size_t n) {
+                    if (p.done) return;
+                    if (ec) { finish(p, false); return; }
+                    p.len += n;
+                    if (!is_reply_prefix(k_slave_addr, 0x03, p.buf, p.len)) { finish(p, false); return; }
+                    const std::size_t need = expected_reply_length(0x03, p.buf, p.len);
+                    if (need != 0 && p.len >= need) {
+                        finish(p, p.buf[1] == 0x03 && modbus::crc16_fast(p.buf, need) == 0);
+                        return;
+                    }
+                    if (p.len >= sizeof(p.buf)) { finish(p, false); return; }
+                    read_more(p);
+                });
         }
 
-        // Timed async read (300ms) to avoid hanging
-        std::vector<unsigned char> rb; rb.reserve(32);
-        asio::steady_timer timer(io_);
-        unsigned char buf[64];
+        void finish(probe_op& p, bool ok) {
+            if (p.done) return;
+            p.done = true;
+            p.timer.cancel();
+            asio::error_code ec;
+            p.port.close(ec);
+            if (!ok) return;
+            results.push_back({p.name,
+                               std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - p.t0),
+                               baud});
+            if (first_only)
+                for (auto& other : ops) finish(*other, false);
+        }
+    };
 
-        timer.expires_after(std::chrono::milliseconds(300));
-        timer.async_wait([&](const asio::error_code&) { port_.cancel(); });
+    // I/O thread only; close_port() is the caller-side form.
+    void safe_close() { bus_->close(); }
 
-        port_.async_read_some(asio::buffer(buf, sizeof(buf)),
-            [&](const asio::error_code& error, std::size_t bytes_transferred) {
-                if (!error && bytes_transferred > 0) {
-                    rb.insert(rb.end(), buf, buf + bytes_transferred);
-                }
-            });
+    void close_port() { call_on_bus([this] { safe_close(); }); }
 
-        io_.run();
-        io_.restart();
+    // CRC16 Modbus (A001 poly), returns crc; wire order is low byte, then high byte.
+    static uint16_t crc16_modbus(const uint8_t* data, size_t len) {
+        return modbus::crc16_fast(data, len);
     }
 
-    // Returns true if connected.
-    bool is_connected() const {
-        return connected_;
+    // Command step: one minimal status request/reply (0x9000..0x9001). status is the
+    // status word, raw the signed position register in device units. A controller that
+    // refuses the short read (exception reply) is switched to the 16-register block for good.
+    void read_status_regs(unique_callback<void(asio::error_code, uint16_t, int16_t)> done) {
+        if (!bus_->is_open()) {
+            done(asio::error::not_connected, 0, 0);
+            return;
+        }
+        const uint8_t* req = narrow_status_ ? k_status_frame.data() : k_probe_frame.data();
+        const std::size_t len = narrow_status_ ? k_status_frame.size() : k_probe_frame.size();
+        // Completes as soon as header + byteCount + CRC are in (9 bytes for the short read)
+        bus_transact(req, len, job_rx_, sizeof(job_rx_),
+            [this, d = std::move(done)](reply_result r) mutable {
+                if (r.status == reply_status::exception && narrow_status_) {
+                    narrow_status_ = false;
+                    read_status_regs(std::move(d));
+                    return;
+                }
+                if (r.status != reply_status::ok || r.len < 7) {
+                    d(make_error_code(r.status == reply_status::ok ? reply_status::io_error : r.status), 0, 0);
+                    return;
+                }
+                // dùng cả 2 bytes trước đó để đọc dấu.
+                // Use bytes 5/6, interpret as signed 16-bit (scaled *100)
+                d(asio::error_code(), be16(job_rx_ + 3), static_cast<int16_t>(be16(job_rx_ + 5)));
+            });
     }
 
-    // Returns current position in external unit (scaled down by 100).
-    // If unavailable, returns 0.
-    int get_current_position() {
-        if (!connected_) return 0;
-        try {
-            // Drain any leftover bytes from previous commands to avoid corrupting this read
-            auto drain_incoming = [&](int window_ms) {
-                using namespace std::chrono;
-                auto deadline = steady_clock::now() + milliseconds(window_ms);
-                unsigned char buf[128];
-                while (steady_clock::now() < deadline) {
-                    asio::steady_timer timer(io_);
-                    bool got = false;
-                    timer.expires_after(milliseconds(20));
-                    timer.async_wait([&](const asio::error_code&) { port_.cancel(); });
-                    port_.async_read_some(asio::buffer(buf, sizeof(buf)),
-                        [&](const asio::error_code& ec, std::size_t n) {
-                            if (!ec && n) got = true; // just consume
-                        });
-                    io_.run();
-                    io_.restart();
-                    if (got) {
-                        // extend quiet window to keep draining while data arrives
-                        deadline = steady_clock::now() + milliseconds(20);
-                    }
-                }
-            };
-            drain_incoming(60);
-
-            // TX request (same as controller_get_position.cpp)
-            const std::vector<uint8_t> req = hex_to_bytes("01 03 90 00 00 10 69 06");
-            asio::write(port_, asio::buffer(req.data(), req.size()));
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-
-            // Read Modbus RTU response: header (3 bytes), then data + CRC (byteCount + 2)
-            unsigned char hdr[3];
-            asio::read(port_, asio::buffer(hdr, 3));
-            const uint8_t byteCount = hdr[2];
-
-            std::vector<unsigned char> tail(byteCount + 2);
-            asio::read(port_, asio::buffer(tail.data(), tail.size()));
-
-            // Assemble full frame
-            std::vector<unsigned char> rx;
-            rx.insert(rx.end(), hdr, hdr + 3);
-            rx.insert(rx.end(), tail.begin(), tail.end());
-
-            // CRC check
-            if (rx.size() < 5) return 0;
-            uint16_t calc_crc = crc16_modbus(rx.data(), rx.size() - 2);
-            uint16_t recv_crc = static_cast<uint16_t>(rx[rx.size() - 2]) |
-                                (static_cast<uint16_t>(rx[rx.size() - 1]) << 8);
-            if (calc_crc != recv_crc) return 0;
-            // dùng cả 2 bytes trước đó để đọc dấu.
-            // Use bytes 5/6, interpret as signed 16-bit (scaled *100), then round
-            if (rx.size() >= 7) {
-                uint16_t raw = (static_cast<uint16_t>(rx[5]) << 8) | static_cast<uint16_t>(rx[6]);
-                int16_t signed_raw = static_cast<int16_t>(raw); // sign extension
-                // sign-aware rounding toward nearest integer
-                int result;
-                if (signed_raw >= 0)
-                    result = (signed_raw + 50) / 100;
-                else
-                    result = (signed_raw - 50) / 100;
-                return result;
-            }
-            return 0;
-        } catch (...) {
-            return 0;
+    // Command step: the full 16-register block into job_rx_.
+    void read_block(unique_callback<void(asio::error_code)> done) {
+        if (!bus_->is_open()) {
+            done(asio::error::not_connected);
+            return;
         }
+        bus_transact(k_probe_frame.data(), k_probe_frame.size(), job_rx_, sizeof(job_rx_),
+            [d = std::move(done)](reply_result r) mutable {
+                if (r.status != reply_status::ok || r.len < 37) {
+                    d(make_error_code(r.status == reply_status::ok ? reply_status::io_error : r.status));
+                    return;
+                }
+                d(asio::error_code());
+            });
     }
 
-    // Blocking variant: same motion as move_relative, but waits until target reached or timeout (seconds).
-    // Returns 0 on success, non-zero on timeout or invalid input; tolerance specifies acceptable position error.
-    int move_relative_blocking(int magnitude, int move_speed, int timeout_sec, int tolerance = 1) {
-        if (!connected_ || magnitude == 0 || timeout_sec <= 0) return 1;
-
-        // Compute expected target from current position before sending commands
-        int start_pos = get_current_position();
-        int expected = std::max(0, start_pos + magnitude);
-        int spd = move_speed;
-        std::cout << "Speed: " << spd << std::endl;
-        if (spd < 1) spd = 1; //else if (spd > 30) spd = 30;
+    static uint16_t be16(const uint8_t* p) {
+        return static_cast<uint16_t>((static_cast<uint16_t>(p[0]) << 8) | p[1]);
+    }
 
-        // Build speed bytes (big-endian)
-        unsigned char speed_hi = static_cast<unsigned char>((spd >> 8) & 0xFF);
-        unsigned char speed_lo = static_cast<unsigned char>(spd & 0xFF);
+    status_snapshot decode_status(uint16_t status, int16_t raw, std::chrono::steady_clock::time_point t) const {
+        status_snapshot st;
+        st.position = scale_position(raw);
+        st.raw = raw;
+        st.status = status;
+        const uint16_t in_position = status_in_position_mask_;
+        st.flags_known = in_position != 0;
+        st.in_position = (status & in_position) != 0;
+        st.busy = (status & status_busy_mask_) != 0;
+        st.alarm = (status & status_alarm_mask_) != 0;
+        st.timestamp = t;
+        return st;
+    }
 
-        // Send the same frames as move_relative (positive vs negative)
-        if (magnitude > 0) {
-            uint16_t val = static_cast<uint16_t>(magnitude * 100);
-            unsigned char hi = static_cast<unsigned char>((val >> 8) & 0xFF);
-            unsigned char lo = static_cast<unsigned char>(val & 0xFF);
-
-            std::vector<unsigned char> command = {
-                0x01, 0x10, 0x91, 0x02, 0x00, 0x10, 0x20, 0x00,
-                0x02, speed_hi, speed_lo, 0x00, 0x00, hi, lo, 0x03,
-                0xe8, 0x03, 0xe8, 0x00, 0x00, 0x00, 0x00, 0x00,
-                0x01, 0x00, 0x64, 0x00, 0x00, 0x00, 0x00, 0x00,
-                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32
-            };
-            uint16_t crc = crc16_modbus(command.data(), command.size());
-            command.push_back(static_cast<unsigned char>(crc & 0xFF));
-            command.push_back(static_cast<unsigned char>((crc >> 8) & 0xFF));
+    // Arrival test: within tolerance, and in position and idle by the controller's own
+    // flags when their bits are known. Right after a start pulse the flags can still be
+    // those of the previous move; see wait_for_position for when they are trusted.
+    static bool settled(const status_snapshot& st, int expected, int tolerance) {
+        if (std::abs(st.position - expected) > tolerance) return false;
+        return !st.flags_known || (st.in_position && !st.busy);
+    }
 
-            asio::write(port_, asio::buffer(command.data(), command.size()));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Device units -> external units, sign-aware rounding toward nearest integer
+    static int scale_position(int16_t signed_raw) {
+        if (signed_raw >= 0) return (signed_raw + 50) / 100;
+        return (signed_raw - 50) / 100;
+    }
 
-            const unsigned char trigger[] = {0x01, 0x10, 0x91, 0x00, 0x00, 0x01, 0x02, 0x01, 0x00, 0x27, 0x09};
-            asio::write(port_, asio::buffer(trigger, sizeof(trigger)));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        } else {
-            uint16_t val = static_cast<uint16_t>(magnitude * 100); // two's complement for negative
-            unsigned char hi = static_cast<unsigned char>((val >> 8) & 0xFF);
-            unsigned char lo = static_cast<unsigned char>(val & 0xFF);
-
-            std::vector<unsigned char> command = {
-                0x01, 0x10, 0x91, 0x02, 0x00, 0x10, 0x20, 0x00,
-                0x02, speed_hi, speed_lo, 0xFF, 0xFF, hi, lo, 0x03,
-                0xE8, 0x03, 0xE8, 0x00, 0x00, 0x00, 0x00, 0x00,
-                0x01, 0x00, 0x64, 0x00, 0x00, 0x00, 0x00, 0x00,
-                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32
-            };
-            uint16_t crc = crc16_modbus(command.data(), command.size());
-            command.push_back(static_cast<unsigned char>(crc & 0xFF));
-            command.push_back(static_cast<unsigned char>((crc >> 8) & 0xFF));
+    // I/O thread: queue one position read on this arm, then schedule the next a period later. gen
+    // ties the chain to one start_telemetry(); a stale chain stops at its next step.
+    void telemetry_poll(uint64_t gen) {
+        if (gen != telemetry_gen_) return;
+        post_job(wire_op::telemetry, [this, gen] {
+            read_status_regs([this, gen](asio::error_code ec, uint16_t status, int16_t raw) {
+                const auto now = std::chrono::steady_clock::now();
+                if (!ec && gen == telemetry_gen_) publish_sample(raw, status, now);
+                finish_command();
+                if (gen != telemetry_gen_) return;
+                telemetry_next_ += telemetry_period_;
+                if (telemetry_next_ < now) telemetry_next_ = now; // overran (slow reply): don't burst to catch up
+                telemetry_timer_.expires_at(telemetry_next_);
+                telemetry_timer_.async_wait(pooled([this, gen](const asio::error_code& tec) {
+                    if (tec) return;
+                    note_wake(wake_kind::poll, telemetry_timer_.expiry());
+                    telemetry_poll(gen);
+                }));
+            });
+        });
+    }
 
-            asio::write(port_, asio::buffer(command.data(), command.size()));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Seqlock writer (single writer: the I/O thread).
+    void publish_sample(int16_t raw, uint16_t status, std::chrono::steady_clock::time_point t) {
+        const uint64_t s = sample_seq_.load(std::memory_order_relaxed);
+        sample_seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        sample_position_.store(scale_position(raw), std::memory_order_relaxed);
+        sample_raw_.store(raw, std::memory_order_relaxed);
+        sample_status_.store(status, std::memory_order_relaxed);
+        sample_time_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  t.time_since_epoch()).count(), std::memory_order_relaxed);
+        sample_seq_.store(s + 2, std::memory_order_release);
+    }
 
-            const unsigned char trigger[] = {0x01, 0x10, 0x91, 0x00, 0x00, 0x01, 0x02, 0x01, 0x00, 0x27, 0x09};
-            asio::write(port_, asio::buffer(trigger, sizeof(trigger)));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    void note_wake(wake_kind kind, std::chrono::steady_clock::time_point intended) {
+        jitter_[static_cast<int>(kind)].record(intended, std::chrono::steady_clock::now());
+    }
 
-            const unsigned char tail[] = {0x01, 0x05, 0x00, 0x1a, 0x00, 0x00, 0xec, 0x0d};
-            asio::write(port_, asio::buffer(tail, sizeof(tail)));
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
+    // Caller-thread poll sleep of a blocking wait, recorded as a poll wake-up.
+    void sleep_until_noted(std::chrono::steady_clock::time_point t) {
+        std::this_thread::sleep_until(t);
+        note_wake(wake_kind::poll, t);
+    }
 
-        // Optional short timed read to avoid hanging on unread acks
-        {
-            std::vector<unsigned char> rb; rb.reserve(32);
-            asio::steady_timer timer(io_);
-            unsigned char buf[32];
-            timer.expires_after(std::chrono::milliseconds(300));
-            timer.async_wait([&](const asio::error_code&){ port_.cancel(); });
-            port_.async_read_some(asio::buffer(buf, sizeof(buf)),
-                [&](const asio::error_code& error, std::size_t bytes_transferred) {
-                    if (!error && bytes_transferred > 0) {
-                        rb.insert(rb.end(), buf, buf + bytes_transferred);
-                    }
-                });
-            io_.run();
-            io_.restart();
+    // Wait until the arm has settled at expected: the in-position flag when status_bits
+    // names it, else |position - expected| <= tolerance; an alarm flag ends the wait. Each
+    // poll is one minimal status read. With a calibrated estimator
+    // this sleeps until margin() before the predicted arrival (measured from `issued`) and
+    // then reads every k_dense_poll; otherwise it reads every k_blind_poll, starting right
+    // away. Telemetry samples taken before `since` are ignored. An arrival bracketed by an
+    // out-of-tolerance reading is fed back to the estimator.
+    bool wait_for_position(int expected, int tolerance, std::chrono::steady_clock::time_point deadline,
+                           std::chrono::steady_clock::time_point since,
+                           std::chrono::steady_clock::time_point issued, std::optional<int> start, int speed) {
+        using namespace std::chrono;
+        settle_report rep;
+        rep.distance = start ? std::abs(expected - *start) : -1;
+        rep.speed = speed;
+        const auto predicted = start ? estimator_.predict(rep.distance, speed) : std::nullopt;
+        rep.calibrated = predicted.has_value();
+        if (predicted) {
+            rep.predicted = *predicted;
+            sleep_until_noted(std::min(issued + *predicted - estimator_.margin(), deadline));
         }
+        const auto period = predicted ? k_dense_poll : k_blind_poll;
 
-        // Poll until target reached or timeout
-        using namespace std::chrono;
-        const auto deadline = steady_clock::now() + seconds(timeout_sec);
+        bool missed = false;
+        steady_clock::time_point last_miss;
+        uint64_t last_seq = 0;
+        // The in-position flag may be left over from the previous move until the drive
+        // takes the start pulse. It is trusted once the move has visibly started (busy
+        // seen, or the position left the start), when there was nothing to move, or, with
+        // the start unknown, when a second read agrees.
+        bool seen_busy = false;
+        int untrusted = 0;
         while (steady_clock::now() < deadline) {
-            std::this_thread::sleep_for(milliseconds(120));
-            int actual = get_current_position();
-            if (std::abs(actual - expected) <= tolerance) return 0; // success within tolerance
+            status_snapshot st;
+            if (telemetry_running()) {
+                const position_sample smp = latest_sample();
+                if (smp.sequence == 0 || smp.sequence == last_seq || smp.timestamp < since) {
+                    sleep_until_noted(steady_clock::now() + telemetry_period_);
+                    continue;
+                }
+                last_seq = smp.sequence;
+                st = decode_status(smp.status, static_cast<int16_t>(smp.raw), smp.timestamp);
+            } else {
+                st = read_status();
+            }
+            ++rep.polls;
+            const steady_clock::time_point at = st.timestamp;
+            if (at == steady_clock::time_point()) { // read failed: neither a hit nor a miss
+                sleep_until_noted(steady_clock::now() + period);
+                continue;
+            }
+            if (st.alarm) {
+                rep.alarm = true;
+                break;
+            }
+            seen_busy = seen_busy || (st.flags_known && st.busy);
+            const bool trusted = !st.flags_known || seen_busy ||
+                                 (start ? st.position != *start || *start == expected : untrusted > 0);
+            const bool hit = settled(st, expected, tolerance);
+            if (hit && !trusted) ++untrusted;
+            if (hit && trusted) {
+                rep.arrived = true;
+                rep.by_flag = st.flags_known;
+                rep.actual = duration_cast<microseconds>((missed ? last_miss + (at - last_miss) / 2 : at) - issued);
+                if (missed && start) estimator_.observe(rep.distance, speed, rep.actual);
+                else if (predicted) estimator_.note_late();
+                known_position_.store(st.position, std::memory_order_relaxed);
+                break;
+            }
+            missed = true;
+            last_miss = at;
+            sleep_until_noted(steady_clock::now() + (telemetry_running() ? telemetry_period_ : period));
         }
-        return 1; // timeout
+        if (rep.arrived) settle_latency_.record(rep.actual);
+        std::lock_guard<std::mutex> lk(settle_mutex_);
+        last_settle_ = rep;
+        return rep.arrived;
     }
 
-    // Blocking variant: same as move_absolute, but waits until target reached or timeout (seconds).
-    // Returns 0 on success, non-zero on timeout/invalid input; tolerance specifies acceptable position error.
-    int move_absolute_blocking(int position, int speed, int timeout_sec, int tolerance = 1) {
-        if (!connected_ || timeout_sec <= 0) return 1;
-        if (speed < 1) speed = 1;
-        // else if (speed > 30) speed = 30; // (unclamped upper if intentional)
-
-        // Compute expected target (external units) with same clamp/scale as move_absolute
-        int scaled = position * 100;
-        if (scaled < 0) scaled = 0;
-        if (scaled > 0xFFFF) scaled = 0xFFFF;
-        const int expected = static_cast<int>((scaled + 50) / 100); // rounded to nearest ext unit
-
-        move_absolute(position, speed);
-
-        // Poll until target reached or timeout
-        using namespace std::chrono;
-        const auto deadline = steady_clock::now() + seconds(timeout_sec);
-        while (steady_clock::now() < deadline) {
-            std::this_thread::sleep_for(milliseconds(120));
-            const int actual = get_current_position();
-            if (std::abs(actual - expected) <= tolerance) return 0; // success within tolerance
+    // connect() on a non-serial transport: open it under `name` (no port scan, no
+    // fingerprint), probe, and run the init sequence.
+    int connect_direct(const std::string& name) {
+        try {
+            call_on_bus([&] { open_and_configure(name, line_.baud); });
+        } catch (...) {
+            close_port();
+            return 1;
         }
-        return 1; // timeout
+        uint8_t rx[256];
+        const reply_result probe = transact(k_probe_frame.data(), k_probe_frame.size(), rx, sizeof(rx), wire_op::probe);
+        if (probe.status != reply_status::ok || !run_init_sequence()) {
+            close_port();
+            return 1;
+        }
+        connected_ = true;
+        connects_.fetch_add(1, std::memory_order_relaxed);
+        port_name_ = name;
+        return 0;
     }
 
-    const std::string& get_port_name() const { return port_name_; }
-
-private:
-    // Helpers
-    static std::vector<std::string> make_port_list() {
-#ifdef _WIN32
-        std::vector<std::string> ports;
-        for (int i = 1; i <= 32; ++i) ports.push_back("COM" + std::to_string(i));
-        return ports;
-#else
-        std::vector<std::string> ports;
-        for (int i = 0; i < 10; ++i) ports.push_back("/dev/ttyUSB" + std::to_string(i));
-        for (int i = 0; i < 32; ++i) ports.push_back("/dev/ttyS" + std::to_string(i));
-        for (int i = 0; i < 64; ++i) ports.push_back("/dev/tty" + std::to_string(i));
+    // connect() for an arm on a shared line: the bus owner opened the port, so only check
+    // that this slave answers and run its init sequence.
+    int connect_on_bus() {
+        uint8_t rx[256];
+        const reply_result probe = transact(k_probe_frame.data(), k_probe_frame.size(), rx, sizeof(rx), wire_op::probe);
+        if (probe.status != reply_status::ok || !run_init_sequence()) return 1;
+        connected_ = true;
+        connects_.fetch_add(1, std::memory_order_relaxed);
+        port_name_ = bus_->port_name();
+        return 0;
+    }
 
-        return ports;
-#endif
+    // Init sequence shared by both connect() paths. Each frame goes out as soon as the
+    // previous reply has arrived and passed CRC, so the sequence runs in wire time.
+    // Failing steps are recorded in init_report_; only strict init stops at the first.
+    bool run_init_sequence() {
+        const auto t0 = std::chrono::steady_clock::now();
+        init_report_ = init_report{};
+        call_on_io([this] { coil_1a_off_ = false; }); // nothing known about the coils yet
+        uint8_t rx[256];
+        for (std::size_t i = 0; i < k_init_frames.size(); ++i) {
+            const auto& f = k_init_frames[i];
+            const reply_result r = transact(f.data(), f.size(), rx, sizeof(rx), wire_op::init, i);
+            if (r.status != reply_status::ok) {
+                if (init_report_.unacked++ == 0) {
+                    init_report_.failed_step = static_cast<int>(i);
+                    init_report_.status = r.status;
+                    init_report_.exception_code = r.exception_code;
+                }
+                std::cout << "[init-error] step " << i << " (func 0x" << std::hex << int(f[1])
+                          << " @ 0x" << ((int(f[2]) << 8) | int(f[3])) << std::dec << "): "
+                          << reply_status_name(r.status) << std::endl;
+                if (strict_init_) break;
+            }
+        }
+        init_report_.ok = init_report_.unacked == 0;
+        init_report_.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - t0);
+        return init_report_.ok || !strict_init_;
     }
 
-    void open_and_configure(const std::string& name) {
-        port_.open(name);
-        port_.set_option(asio::serial_port_base::baud_rate(38400));
-        port_.set_option(asio::serial_port_base::character_size(8));
-        port_.set_option(asio::serial_port_base::parity(asio::serial_port_base::parity::none));
-        port_.set_option(asio::serial_port_base::stop_bits(asio::serial_port_base::stop_bits::one));
-        port_.set_option(asio::serial_port_base::flow_control(asio::serial_port_base::flow_control::none));
+    // Time to shift n bytes at 8N1 (10 bits per character; 11 would be 8E1/8N2).
+    static std::chrono::microseconds wire_time(std::size_t n, unsigned baud) {
+        return std::chrono::microseconds((static_cast<long long>(n) * 10 * 1000000LL) / baud);
     }
 
-    void safe_close() {
-        if (port_.is_open()) {
-            asio::error_code ec;
-            port_.close(ec);
-        }
+    // Longest reply a request can get: a read's full register block, else the 8-byte
+    // write echo.
+    static std::size_t max_reply_length(const uint8_t* req) {
+        if (req[1] == 0x01 || req[1] == 0x02)
+            return 5 + (((static_cast<std::size_t>(req[4]) << 8) | req[5]) + 7) / 8;
+        if (req[1] == 0x03 || req[1] == 0x04)
+            return 5 + 2 * ((static_cast<std::size_t>(req[4]) << 8) | req[5]);
+        return 8;
     }
 
-    // CRC16 Modbus (A001 poly), returns crc; wire order is low byte, then high byte.
-    static uint16_t crc16_modbus(const uint8_t* data, size_t len) {
-        uint16_t crc = 0xFFFF;
-        for (size_t i = 0; i < len; ++i) {
-            crc ^= static_cast<uint8_t>(data[i]);
-            for (int j = 0; j < 8; ++j) {
-                if (crc & 0x0001) crc = (crc >> 1) ^ 0xA001;
-                else crc >>= 1;
-            }
-        }
-        return crc;
+    // Caller-side transaction for connect() and init: queued like any other command.
+    reply_result transact(const uint8_t* req, std::size_t len, uint8_t* rx, std::size_t cap,
+                          wire_op op = wire_op::init, std::size_t init_step = 0) {
+        require_caller_thread();
+        sync_waiter w;
+        reply_result out;
+        post_job(op, [&] {
+            init_step_ = init_step;
+            bus_transact(req, len, rx, cap, [&](reply_result r) {
+                out = r;
+                finish_command();
+                w.signal();
+            });
+        });
+        w.wait();
+        return out;
     }
 
     static void append_crc(std::vector<uint8_t>& frame) {
@@ -676,301 +4305,698 @@ private:
         return out;
     }
 
-    void write_frame(const std::vector<uint8_t>& frame) {
-        asio::write(port_, asio::buffer(frame.data(), frame.size()));
-        // small delay to allow device to respond
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
-    }
-
-    // Read Modbus RTU response: first 3 bytes (addr, func, byteCount), then tail (byteCount + 2)
-    std::optional<std::vector<uint8_t>> read_modbus_response() {
-        try {
-            uint8_t hdr[3];
-            asio::read(port_, asio::buffer(hdr, 3));
-            uint8_t byteCount = hdr[2];
-            std::vector<uint8_t> tail(byteCount + 2);
-            asio::read(port_, asio::buffer(tail.data(), tail.size()));
-            std::vector<uint8_t> rx;
-            rx.insert(rx.end(), hdr, hdr + 3);
-            rx.insert(rx.end(), tail.begin(), tail.end());
-            return rx;
-        } catch (...) {
-            return std::nullopt;
+    // Total length of the reply to `func` once enough of its head is known, else 0.
+    // Exception replies (func | 0x80) are addr, func, code + CRC; write acks echo 8 bytes.
+    static std::size_t expected_reply_length(uint8_t func, const uint8_t* f, std::size_t len) {
+        if (len < 2) return 0;
+        if (f[1] == (func | 0x80)) return 5;
+        if (func == 0x01 || func == 0x02 || func == 0x03 || func == 0x04) {
+            if (len < 3) return 0;
+            return 5 + static_cast<std::size_t>(f[2]);
         }
+        return 8;
     }
 
-    // Read exactly n bytes (blocking, minimal error handling)
-    bool read_exact(uint8_t* dst, std::size_t n) {
-        try {
-            std::size_t total = 0;
-            while (total < n) {
-                total += asio::read(port_, asio::buffer(dst + total, n - total));
-            }
-            return true;
-        } catch (...) { return false; }
+    // Could f[0..len) still grow into slave's reply to func?
+    static bool is_reply_prefix(uint8_t slave, uint8_t func, const uint8_t* f, std::size_t len) {
+        if (len >= 1 && f[0] != slave) return false;
+        if (len >= 2 && f[1] != func && f[1] != (func | 0x80)) return false;
+        return true;
     }
 
 private:
-    asio::io_context io_;
-    asio::serial_port port_;
+    static constexpr uint8_t k_slave_addr = 0x01;
+    // Timed replies needed before the first attempt's deadline follows the measured p99
+    static constexpr std::size_t k_rtt_min_samples = 8;
+    // Per-port deadline for discovery probes
+    static constexpr int k_probe_timeout_ms = 200;
+
+    // Probe / position block: 01 03 90 00 00 10 69 06
+    static constexpr auto k_probe_frame = modbus::read_holding(k_slave_addr, 0x9000, 0x0010);
+    // Status read, first two words of that block: 01 03 90 00 00 02 e9 0b
+    static constexpr auto k_status_frame = modbus::read_holding(k_slave_addr, 0x9000, 0x0002);
+    // Relative move parameter block (speed, sign and delta are patched at runtime)
+    static constexpr auto k_relative_move_frame = modbus::write_registers(k_slave_addr, 0x9102,
+        std::array<uint16_t, 16>{0x0002, 0x0000, 0x0000, 0x0000, 0x03e8, 0x03e8, 0x0000, 0x0000,
+                                 0x0001, 0x0064, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0032});
+    // Relative move trigger: 01 10 91 00 00 01 02 01 00 27 09
+    static constexpr auto k_relative_trigger_frame =
+        modbus::write_registers(k_slave_addr, 0x9100, std::array<uint16_t, 1>{0x0100});
+    // Coil 0x001A OFF: 01 05 00 1a 00 00 ec 0d
+    static constexpr auto k_coil_1a_off_frame = modbus::write_coil(k_slave_addr, 0x001A, false);
+    // Absolute move speed (0x0411) and position (0x0412, leading zero register) frames
+    static constexpr auto k_abs_speed_frame =
+        modbus::write_registers(k_slave_addr, 0x0411, std::array<uint16_t, 1>{0x0000});
+    static constexpr auto k_abs_position_frame =
+        modbus::write_registers(k_slave_addr, 0x0412, std::array<uint16_t, 2>{0x0000, 0x0000});
+    // Absolute move post-sequence: coil 0x001A OFF, multi-coil 0x0010, then a 0x001A ON/OFF pulse
+    static constexpr auto k_coil_1a_on_frame = modbus::write_coil(k_slave_addr, 0x001A, true);
+    static constexpr auto k_abs_multi_coil_frame =
+        modbus::write_coils(k_slave_addr, 0x0010, 0x0008, std::array<uint8_t, 1>{0x01});
+    static constexpr std::array<modbus::frame_view, 4> k_abs_start_frames = {
+        modbus::frame_view(k_coil_1a_off_frame), modbus::frame_view(k_abs_multi_coil_frame),
+        modbus::frame_view(k_coil_1a_on_frame), modbus::frame_view(k_coil_1a_off_frame)};
+    // Fast absolute move: speed, zero register and position as one write to 0x0411..0x0413,
+    // and the post-sequence without its leading coil OFF (see add_absolute_start)
+    static constexpr auto k_abs_params_frame =
+        modbus::write_registers(k_slave_addr, 0x0411, std::array<uint16_t, 3>{0x0000, 0x0000, 0x0000});
+    static constexpr std::array<modbus::frame_view, 3> k_abs_fast_start_frames = {
+        modbus::frame_view(k_abs_multi_coil_frame), modbus::frame_view(k_coil_1a_on_frame),
+        modbus::frame_view(k_coil_1a_off_frame)};
+
+    // Builder output must match the documented captures byte-for-byte.
+    static_assert(k_probe_frame == modbus::checked({0x01, 0x03, 0x90, 0x00, 0x00, 0x10, 0x69, 0x06}),
+                  "probe frame");
+    static_assert(k_status_frame == modbus::checked({0x01, 0x03, 0x90, 0x00, 0x00, 0x02, 0xe9, 0x0b}),
+                  "status frame");
+    static_assert(k_relative_trigger_frame ==
+                  modbus::checked({0x01, 0x10, 0x91, 0x00, 0x00, 0x01, 0x02, 0x01, 0x00, 0x27, 0x09}),
+                  "relative trigger frame");
+    static_assert(k_coil_1a_off_frame == modbus::checked({0x01, 0x05, 0x00, 0x1a, 0x00, 0x00, 0xec, 0x0d}),
+                  "coil 0x001A OFF frame");
+    static_assert(k_coil_1a_on_frame == modbus::checked({0x01, 0x05, 0x00, 0x1a, 0xff, 0x00, 0xad, 0xfd}),
+                  "coil 0x001A ON frame");
+    static_assert(k_abs_multi_coil_frame ==
+                  modbus::checked({0x01, 0x0f, 0x00, 0x10, 0x00, 0x08, 0x01, 0x01, 0xfe, 0x96}),
+                  "multi-coil frame");
+
+    // connect() initialization sequence, captured from the vendor tool. Semantics are not
+    // decoded yet, so the frames are kept byte-for-byte (CRCs verified at compile time).
+    static constexpr std::array<modbus::frame<8>, k_init_steps> k_init_frames = {
+        modbus::checked({0x01, 0x03, 0x00, 0x0e, 0x00, 0x08, 0x25, 0xcf}),
+        modbus::checked({0x01, 0x03, 0x00, 0x52, 0x00, 0x02, 0x65, 0xda}),
+        modbus::checked({0x01, 0x03, 0x00, 0x00, 0x00, 0x70, 0x44, 0x2e}),
+        modbus::checked({0x01, 0x03, 0x00, 0x70, 0x00, 0x70, 0x45, 0xf5}),
+        modbus::checked({0x01, 0x03, 0x00, 0xe0, 0x00, 0x70, 0x45, 0xd8}),
+        modbus::checked({0x01, 0x03, 0x01, 0x50, 0x00, 0x30, 0x44, 0x33}),
+        modbus::checked({0x01, 0x03, 0x03, 0x80, 0x00, 0x40, 0x45, 0x96}),
+        modbus::checked({0x01, 0x03, 0x04, 0x00, 0x00, 0x70, 0x45, 0x1e}),
+        modbus::checked({0x01, 0x03, 0x04, 0x70, 0x00, 0x70, 0x44, 0xc5}),
+        modbus::checked({0x01, 0x03, 0x04, 0xe0, 0x00, 0x70, 0x44, 0xe8}),
+        modbus::checked({0x01, 0x03, 0x05, 0x50, 0x00, 0x70, 0x44, 0xf3}),
+        modbus::checked({0x01, 0x03, 0x05, 0xc0, 0x00, 0x70, 0x44, 0xde}),
+        modbus::checked({0x01, 0x03, 0x06, 0x30, 0x00, 0x70, 0x44, 0xa9}),
+        modbus::checked({0x01, 0x03, 0x06, 0xa0, 0x00, 0x70, 0x44, 0x84}),
+        modbus::checked({0x01, 0x03, 0x07, 0x10, 0x00, 0x70, 0x44, 0x9f}),
+        modbus::checked({0x01, 0x03, 0x07, 0x80, 0x00, 0x70, 0x44, 0xb2}),
+        modbus::checked({0x01, 0x03, 0x07, 0xf0, 0x00, 0x10, 0x45, 0x41}),
+        modbus::checked({0x01, 0x03, 0x90, 0x11, 0x00, 0x02, 0xb9, 0x0e}),
+        modbus::checked({0x01, 0x05, 0x00, 0x30, 0xff, 0x00, 0x8c, 0x35}),
+        modbus::checked({0x01, 0x05, 0x00, 0x19, 0xff, 0x00, 0x5d, 0xfd})
+    };
+
+    std::unique_ptr<asio::io_context> own_io_; // standalone controllers only
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>> own_work_;
+    std::shared_ptr<serial_bus> bus_;
+    std::size_t client_;
+    uint8_t slave_;
+    bool owns_bus_;
+    asio::steady_timer pause_timer_;
+    asio::steady_timer telemetry_timer_;
     bool connected_;
     std::string port_name_;
+    bool narrow_status_ = true; // I/O thread only; false once the short status read was refused
+    std::atomic<uint16_t> status_busy_mask_{0};
+    std::atomic<uint16_t> status_in_position_mask_{0};
+    std::atomic<uint16_t> status_alarm_mask_{0};
+    std::string port_cache_path_ = default_port_cache_path();
+    line_settings line_;
+
+    // The command holding this arm (I/O thread only)
+    wire_op op_ = wire_op::other;
+    std::size_t init_step_ = 0; // I/O thread: init sequence step of the command in flight
+    command_batch batch_;
+    uint8_t job_rx_[256];
+    trajectory_run traj_;
+
+    // Telemetry poll chain and its seqlock-published sample
+    std::atomic<bool> telemetry_on_{false};
+    std::chrono::milliseconds telemetry_period_{20};
+    uint64_t telemetry_gen_ = 0;                         // I/O thread only
+    std::chrono::steady_clock::time_point telemetry_next_; // I/O thread only
+    std::atomic<uint64_t> sample_seq_{0};
+    std::atomic<int32_t> sample_position_{0};
+    std::atomic<int32_t> sample_raw_{0};
+    std::atomic<uint16_t> sample_status_{0};
+    std::atomic<int64_t> sample_time_ns_{0};
+    init_report init_report_;
+    bool strict_init_ = false; // caller thread: read by connect()
+
+    std::atomic<absolute_mode> absolute_mode_{absolute_mode::legacy};
+    // Where the last blocking move arrived, until the next motion command is queued
+    static constexpr int64_t k_position_unknown = INT64_MIN;
+    std::atomic<int64_t> known_position_{k_position_unknown};
+    bool coil_1a_off_ = false; // I/O thread only: our last sequence left coil 0x001A OFF
+
+    // Transaction bounds (any thread) and turnaround measurements (I/O thread only)
+    mutable std::mutex policy_mutex_;
+    transaction_policy policy_;
+    rtt_window rtt_;
+
+    // Metrics (written on the I/O thread, except settle and connects; read from any thread)
+    std::array<latency_histogram, k_wire_ops> command_latency_;
+    std::array<latency_histogram, k_init_steps> init_latency_; // by init sequence step
+    latency_histogram txn_latency_;
+    latency_histogram settle_latency_;
+    std::chrono::steady_clock::time_point command_start_; // I/O thread only
+    std::atomic<uint64_t> txn_count_{0};
+    std::atomic<uint64_t> txn_retries_{0};
+    std::atomic<uint64_t> txn_timeouts_{0};
+    std::atomic<uint64_t> txn_crc_errors_{0};
+    std::atomic<uint64_t> txn_exceptions_{0};
+    std::atomic<uint64_t> txn_io_errors_{0};
+    std::atomic<uint64_t> connects_{0};
+
+    // Wake-up lateness by wake_kind (any thread)
+    std::array<jitter_recorder, 2> jitter_;
+
+    // Blocking-move arrival model and the last wait's outcome (caller threads)
+    motion_estimator estimator_;
+    mutable std::mutex settle_mutex_;
+    settle_report last_settle_;
+
+    // Standalone only; started last, after everything it touches is constructed
+    std::thread io_thread_;
 };
 
-// Randomized stress test for move_relative (+/-) with verification via get_current_position
-static void stress_test_move_relative_blocking(act_controller& ctrl,
-                                               int iterations,
-                                               int min_pos,
-                                               int max_pos,
-                                               int max_step,
-                                               int settle_timeout_ms = 1500,
-                                               int tolerance = 1) {
-    using namespace std::chrono;
-    if (min_pos > max_pos) std::swap(min_pos, max_pos);
-    if (min_pos < 0) min_pos = 0;
-
-    std::mt19937 rng(static_cast<unsigned int>(steady_clock::now().time_since_epoch().count()));
-    std::uniform_int_distribution<int> delta_dist(-max_step, max_step);
-    std::uniform_int_distribution<int> spd_dist(1, 30);
-
-    int pass = 0, fail = 0;
-
-    int expected = std::clamp(ctrl.get_current_position(), min_pos, max_pos);
-
-    for (int i = 0; i < iterations; ++i) {
-        int before = expected;
-
-        int delta = 0;
-        for (int tries = 0; tries < 64 && delta == 0; ++tries) {
-            int cand = delta_dist(rng);
-            if (cand == 0) continue;
-            int target = before + cand;
-            if (target >= min_pos && target <= max_pos) delta = cand;
-        }
-        if (delta == 0) {
-            int to_min = before - min_pos;
-            int to_max = max_pos - before;
-            if (to_max >= to_min) delta = std::min(max_step, to_max);
-            else delta = -std::min(max_step, to_min);
-            if (delta == 0) delta = (to_max > 0 ? 1 : (to_min > 0 ? -1 : 0));
-        }
-
-        int speed = spd_dist(rng);
-        int timeout_sec = std::max(1, (settle_timeout_ms + 999) / 1000);
-
-        expected = std::clamp(before + delta, min_pos, max_pos);
-        int rc = ctrl.move_relative_blocking(delta, speed, timeout_sec, tolerance);
-
-        // Read back final position and verify within tolerance
-        int actual = ctrl.get_current_position();
-        bool ok = (rc == 0) && (std::abs(actual - expected) <= tolerance);
-        if (ok) ++pass;
-        else {
-            ++fail;
-            std::cout << "[fail] i=" << i
-                      << " before=" << before
-                      << " delta=" << delta
-                      << " speed=" << speed
-                      << " expected=" << expected
-                      << " got=" << actual
-                      << " rc=" << rc << std::endl;
-        }
-
-        if ((i + 1) % 100 == 0) {
-            std::cout << "[progress] " << (i + 1) << "/" << iterations
-                      << " pass=" << pass << " fail=" << fail << std::endl;
+// Many arms from one process. Each serial port is one serial_bus shared by the arms
+// (slave addresses) on that line; the buses are spread over a fixed set of I/O threads,
+// one io_context each, so adding arms or ports adds no threads. Per-arm command queues
+// and the round-robin slot scheduler live in serial_bus.
+class act_controller_pool {
+public:
+    explicit act_controller_pool(std::size_t io_threads = 1) {
+        if (io_threads == 0) io_threads = 1;
+        for (std::size_t i = 0; i < io_threads; ++i) {
+            ios_.push_back(std::make_unique<asio::io_context>());
+            work_.push_back(asio::make_work_guard(*ios_.back()));
         }
+        for (auto& io : ios_) threads_.emplace_back([ctx = io.get()] { act_controller::run_io(*ctx); });
     }
 
-    std::cout << "[summary] iterations=" << iterations
-              << " pass=" << pass << " fail=" << fail << std::endl;
-}
+    ~act_controller_pool() {
+        arms_.clear(); // each arm waits for its own queued commands
+        for (auto& l : lines_) {
+            act_controller::sync_waiter w;
+            asio::post(l.bus->io(), [&] {
+                l.bus->close();
+                w.signal();
+            });
+            w.wait();
+        }
+        work_.clear();
+        for (auto& t : threads_) t.join();
+    }
 
-// Randomized stress test for move_relative within a position range [min_pos, max_pos]
-static void stress_test_move_relative(act_controller& ctrl,
-                                      int iterations,
-                                      int min_pos,
-                                      int max_pos,
-                                      int max_step,
-                                      int settle_timeout_ms = 1500,
-                                      int tolerance = 1) {
-    using namespace std::chrono;
-    if (min_pos > max_pos) std::swap(min_pos, max_pos);
-    if (min_pos < 0) min_pos = 0;
-
-    std::mt19937 rng(static_cast<unsigned int>(steady_clock::now().time_since_epoch().count()));
-    std::uniform_int_distribution<int> delta_dist(-max_step, max_step);
-    std::uniform_int_distribution<int> spd_dist(1, 30);
-
-    int pass = 0, fail = 0;
-
-    // Initialize expected once and clamp to the allowed range
-    int expected = std::clamp(ctrl.get_current_position(), min_pos, max_pos);
-
-    for (int i = 0; i < iterations; ++i) {
-        // Base next command off the expected (not the last measured "got")
-        int before = expected;
-
-        // Pick a delta that keeps target within [min_pos, max_pos]
-        int delta = 0;
-        for (int tries = 0; tries < 64 && delta == 0; ++tries) {
-            int cand = delta_dist(rng);
-            if (cand == 0) continue;
-            int target = before + cand;
-            if (target >= min_pos && target <= max_pos) delta = cand;
-        }
-        // If we couldn't find a random delta, nudge toward the nearest bound
-        if (delta == 0) {
-            if (before < min_pos) delta = std::min(max_step, min_pos - before);
-            else if (before > max_pos) delta = -std::min(max_step, before - max_pos);
-            else {
-                int to_min = before - min_pos;
-                int to_max = max_pos - before;
+    act_controller_pool(const act_controller_pool&) = delete;
+    act_controller_pool& operator=(const act_controller_pool&) = delete;
+
+    // Add the arm answering to `slave` on `port`. The first arm on a port opens it at
+    // `baud` (asio::system_error if that fails); later arms share the line and its rate.
+    // Call connect() (or connect_all()) before commanding it.
+    act_controller& add(const std::string& port, uint8_t slave,
+                        unsigned baud = act_controller::k_default_baud) {
+        line& l = line_for(port, baud);
+        arms_.push_back(std::make_unique<act_controller>(l.bus, slave));
+        return *arms_.back();
+    }
+
+    std::size_t size() const { return arms_.size(); }
+    act_controller& operator[](std::size_t i) { return *arms_[i]; }
+    std::size_t io_threads() const { return threads_.size(); }
+
+    // Real-time mode for every I/O thread of the pool. With opt.cpus, thread i is pinned
+    // to cpus[i % cpus.size()], so the lines are spread over the reserved cores.
+    std::vector<act_controller::realtime_report> enable_realtime(const act_controller::realtime_options& opt) {
+        std::vector<act_controller::realtime_report> out(ios_.size());
+        for (std::size_t i = 0; i < ios_.size(); ++i) {
+            const int cpu = opt.cpus.empty() ? -1 : opt.cpus[i % opt.cpus.size()];
+            act_controller::sync_waiter w;
+            asio::post(*ios_[i], [&, i, cpu] {
+                out[i] = act_controller::make_thread_realtime(opt, cpu);
+                w.signal();
+            });
+            w.wait();
+        }
+        return out;
+    }
+    std::size_t lines() const { return lines_.size(); }
+
+    // Probe and initialize every arm; returns how many failed.
+    int connect_all() {
+        int failed = 0;
+        for (auto& a : arms_)
+            if (a->connect() != 0) ++failed;
+        return failed;
+    }
+
+    void disconnect_all() {
+        for (auto& a : arms_) a->disconnect();
+    }
+
+private:
+    struct line {
+        std::string port;
+        std::shared_ptr<act_controller::serial_bus> bus;
+    };
+
+    line& line_for(const std::string& port, unsigned baud) {
+        for (auto& l : lines_)
+            if (l.port == port) return l;
+        asio::io_context& io = *ios_[lines_.size() % ios_.size()];
+        auto bus = std::make_shared<act_controller::serial_bus>(io);
+        bus->open(port, baud); // nothing submitted yet, so the caller's thread may do this
+        lines_.push_back({port, std::move(bus)});
+        return lines_.back();
+    }
+
+    std::vector<std::unique_ptr<asio::io_context>> ios_;
+    std::vector<asio::executor_work_guard<asio::io_context::executor_type>> work_;
+    std::vector<std::thread> threads_;
+    std::deque<line> lines_;
+    std::vector<std::unique_ptr<act_controller>> arms_;
+};
+
+// One step of a stress workload, applied to an arm by stress_engine.
+struct stress_step {
+    enum class action {
+        relative,        // move_relative_blocking(value), then read back
+        relative_polled, // move_relative(value), then poll the position every 120 ms
+        absolute,        // move_absolute_blocking(value), then read back
+        reconnect        // disconnect, wait `dwell`, connect to the same port again
+    };
+    action kind = action::relative;
+    int value = 0;                      // delta (relative) or target (absolute)
+    int speed = 1;
+    std::chrono::milliseconds dwell{0}; // pause after the step (press hold, churn gap)
+};
+
+// A workload: given the arm's PRNG and the position the arm should be at, the next step.
+// Each arm runs its own copy, so a generator may keep state (a press cycle alternates).
+// op is the API call its steps make, whose command latency the report shows.
+struct stress_workload {
+    std::string name;
+    act_controller::wire_op op = act_controller::wire_op::other;
+    std::function<stress_step(std::mt19937& rng, int position)> next;
+};
+
+// Runs a workload on several arms at once, one thread per arm, and measures it: steps/sec,
+// settle time percentiles, the arms' command latency and how busy each line was. Arm i
+// draws from mt19937(seed + i), so a run is repeatable for a given seed and arm order.
+class stress_engine {
+public:
+    using latency_histogram = act_controller::latency_histogram;
+
+    struct config {
+        int iterations = 100;     // steps per arm
+        uint32_t seed = 1;
+        int settle_timeout_ms = 1500;
+        int tolerance = 1;
+        int progress_every = 100; // per-arm progress line every N steps, 0 for none
+        bool log_failures = true;
+    };
+
+    struct arm_report {
+        std::string port;
+        int steps = 0;
+        int pass = 0;
+        int fail = 0;
+        double seconds = 0;
+        double steps_per_second = 0;
+        // Per step: command sent -> arrival (blocking moves from settle_report, polled moves
+        // at poll granularity), or the connect() time of a reconnect.
+        latency_histogram::summary settle;
+        long long polls = 0;             // position reads of the blocking waits
+        int predicted = 0;               // blocking moves that arrived on an estimator prediction
+        double mean_abs_error_ms = 0;    // |actual - predicted| over those
+        // The arm's metrics for the run alone (metrics_since() a mark taken at the start)
+        act_controller::metrics_report metrics;
+        double bus_utilization = 0;      // request/reply time over wall time (0..1 per arm)
+    };
+
+    struct report {
+        std::string workload;
+        act_controller::wire_op op = act_controller::wire_op::other;
+        std::vector<arm_report> arms;
+        int steps = 0;
+        int pass = 0;
+        int fail = 0;
+        double seconds = 0;
+        double steps_per_second = 0;     // all arms together
+        latency_histogram::summary settle; // all arms together
+    };
+
+    // Random relative moves keeping the target in [min_pos, max_pos], |delta| <= max_step,
+    // speed 1..30. polled: move_relative plus position polling instead of the blocking call.
+    static stress_workload random_relative(int min_pos, int max_pos, int max_step, bool polled = false) {
+        if (min_pos > max_pos) std::swap(min_pos, max_pos);
+        if (min_pos < 0) min_pos = 0;
+        if (max_step < 1) max_step = 1;
+        stress_workload w;
+        w.name = polled ? "random_relative_polled" : "random_relative";
+        w.op = act_controller::wire_op::move_relative;
+        w.next = [=](std::mt19937& rng, int position) {
+            std::uniform_int_distribution<int> delta_dist(-max_step, max_step);
+            std::uniform_int_distribution<int> spd_dist(1, 30);
+            int delta = 0;
+            for (int tries = 0; tries < 64 && delta == 0; ++tries) {
+                const int cand = delta_dist(rng);
+                if (cand != 0 && position + cand >= min_pos && position + cand <= max_pos) delta = cand;
+            }
+            // If no random delta fits, nudge toward the far bound
+            if (delta == 0) {
+                const int to_min = position - min_pos;
+                const int to_max = max_pos - position;
                 delta = (to_max >= to_min) ? std::min(max_step, to_max) : -std::min(max_step, to_min);
                 if (delta == 0) delta = (to_max > 0) ? 1 : (to_min > 0 ? -1 : 0);
             }
-        }
+            stress_step s;
+            s.kind = polled ? stress_step::action::relative_polled : stress_step::action::relative;
+            s.value = delta;
+            s.speed = spd_dist(rng);
+            return s;
+        };
+        return w;
+    }
+
+    // Random absolute targets in [min_pos, max_pos], speed 1..30.
+    static stress_workload random_absolute(int min_pos, int max_pos) {
+        if (min_pos > max_pos) std::swap(min_pos, max_pos);
+        if (min_pos < 0) min_pos = 0;
+        stress_workload w;
+        w.name = "random_absolute";
+        w.op = act_controller::wire_op::move_absolute;
+        w.next = [=](std::mt19937& rng, int) {
+            stress_step s;
+            s.kind = stress_step::action::absolute;
+            s.value = std::uniform_int_distribution<int>(min_pos, max_pos)(rng);
+            s.speed = std::uniform_int_distribution<int>(1, 30)(rng);
+            return s;
+        };
+        return w;
+    }
 
-        int speed = spd_dist(rng);
-        ctrl.move_relative(delta, speed);
+    // Press and retract: absolute moves alternating between press_pos and rest_pos at
+    // `speed`, holding `dwell` at each end. Two steps per press.
+    static stress_workload press_cycle(int rest_pos, int press_pos, int speed,
+                                       std::chrono::milliseconds dwell = std::chrono::milliseconds(0)) {
+        stress_workload w;
+        w.name = "press_cycle";
+        w.op = act_controller::wire_op::move_absolute;
+        w.next = [=, down = false](std::mt19937&, int) mutable {
+            down = !down;
+            stress_step s;
+            s.kind = stress_step::action::absolute;
+            s.value = down ? press_pos : rest_pos;
+            s.speed = speed;
+            s.dwell = dwell;
+            return s;
+        };
+        return w;
+    }
 
-        // Update expected as the commanded/clamped target
-        expected = std::clamp(before + delta, min_pos, max_pos);
+    // Disconnect and reconnect to the same port, `gap` after the disconnect.
+    static stress_workload connect_churn(std::chrono::milliseconds gap = std::chrono::milliseconds(50)) {
+        stress_workload w;
+        w.name = "connect_churn";
+        w.op = act_controller::wire_op::probe;
+        w.next = [=](std::mt19937&, int) {
+            stress_step s;
+            s.kind = stress_step::action::reconnect;
+            s.dwell = gap;
+            return s;
+        };
+        return w;
+    }
 
-        // Verify by polling actual until settled or timeout
-        int actual = before;
-        auto t0 = steady_clock::now();
-        while (steady_clock::now() - t0 < milliseconds(settle_timeout_ms)) {
-            std::this_thread::sleep_for(milliseconds(120));
-            actual = ctrl.get_current_position();
-            if (std::abs(actual - expected) <= tolerance) break;
+    // Run `work` on every arm (connected beforehand) and wait for all of them.
+    static report run(const std::vector<act_controller*>& arms, const stress_workload& work, const config& cfg) {
+        using namespace std::chrono;
+        report out;
+        out.workload = work.name;
+        out.op = work.op;
+        out.arms.resize(arms.size());
+        latency_histogram all;
+        std::mutex print_mutex;
+        const auto t0 = steady_clock::now();
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < arms.size(); ++i)
+            threads.emplace_back([&, i] {
+                run_arm(*arms[i], i, work, cfg, out.arms[i], all, print_mutex);
+            });
+        for (auto& t : threads) t.join();
+        out.seconds = duration<double>(steady_clock::now() - t0).count();
+        for (const auto& a : out.arms) {
+            out.steps += a.steps;
+            out.pass += a.pass;
+            out.fail += a.fail;
         }
+        out.steps_per_second = out.seconds > 0 ? out.steps / out.seconds : 0.0;
+        out.settle = all.get();
+        return out;
+    }
 
-        if (std::abs(actual - expected) <= tolerance) {
-            ++pass;
-        } else {
-            ++fail;
-            std::cout << "[fail] i=" << i
-                      << " before=" << before
-                      << " delta=" << delta
-                      << " speed=" << speed
-                      << " expected=" << expected
-                      << " got=" << actual << std::endl;
+    // One [stress-arm] line per arm with the command latency of the workload's own
+    // API call, then a [stress] total.
+    static void print(const report& r) {
+        for (std::size_t i = 0; i < r.arms.size(); ++i) {
+            const arm_report& a = r.arms[i];
+            const latency_histogram::summary& cmd = a.metrics.commands[static_cast<std::size_t>(r.op)];
+            std::cout << "[stress-arm] " << r.workload << " arm=" << i << " port=" << a.port
+                      << " steps=" << a.steps << " pass=" << a.pass << " fail=" << a.fail
+                      << " steps/s=" << a.steps_per_second << " settle_p50_us=" << a.settle.p50.count()
+                      << " settle_p99_us=" << a.settle.p99.count() << " settle_max_us=" << a.settle.max.count()
+                      << " cmd_p50_us=" << cmd.p50.count() << " cmd_p99_us=" << cmd.p99.count()
+                      << " retries=" << a.metrics.retries << " timeouts=" << a.metrics.timeouts
+                      << " bus_util=" << a.bus_utilization << std::endl;
         }
+        std::cout << "[stress] " << r.workload << " arms=" << r.arms.size() << " steps=" << r.steps
+                  << " pass=" << r.pass << " fail=" << r.fail << " seconds=" << r.seconds
+                  << " steps/s=" << r.steps_per_second << " settle_p50_us=" << r.settle.p50.count()
+                  << " settle_p99_us=" << r.settle.p99.count() << " settle_max_us=" << r.settle.max.count() << std::endl;
+    }
+
+private:
+    // Log tags of the single-arm stress tests, by the workload's API call
+    static const char* progress_tag(act_controller::wire_op op) {
+        if (op == act_controller::wire_op::move_absolute) return "[abs-progress]";
+        if (op == act_controller::wire_op::probe) return "[conn-progress]";
+        return "[progress]";
+    }
+
+    static void run_arm(act_controller& ctrl, std::size_t index, const stress_workload& work, const config& cfg,
+                        arm_report& out, latency_histogram& all, std::mutex& print_mutex) {
+        using namespace std::chrono;
+        using action = stress_step::action;
+        std::mt19937 rng(cfg.seed + static_cast<uint32_t>(index));
+        stress_workload gen = work; // generator state is per arm
+        latency_histogram settle;
+        const auto base = std::make_unique<act_controller::metrics_mark>(ctrl.mark_metrics());
+        out.port = ctrl.get_port_name();
+        const int timeout_sec = std::max(1, (cfg.settle_timeout_ms + 999) / 1000);
+        double abs_error_ms = 0;
+
+        // Each step is based off the expected position, not the last one measured
+        int expected = ctrl.is_connected() ? std::max(0, ctrl.get_current_position()) : 0;
+        const auto t0 = steady_clock::now();
+        for (int i = 0; i < cfg.iterations; ++i) {
+            const stress_step s = gen.next(rng, expected);
+            const int before = expected;
+            int rc = 0;
+            int actual = before;
+            bool ok = false;
+            std::optional<microseconds> took;
+            switch (s.kind) {
+            case action::relative:
+            case action::absolute: {
+                if (s.kind == action::relative) {
+                    expected = std::max(0, before + s.value);
+                    rc = ctrl.move_relative_blocking(s.value, s.speed, timeout_sec, cfg.tolerance);
+                } else {
+                    expected = std::clamp(s.value, 0, 0xFFFF / 100);
+                    rc = ctrl.move_absolute_blocking(s.value, s.speed, timeout_sec, cfg.tolerance);
+                }
+                const act_controller::settle_report st = ctrl.last_settle_report();
+                out.polls += st.polls;
+                if (st.arrived) took = st.actual;
+                if (st.arrived && st.calibrated) {
+                    ++out.predicted;
+                    abs_error_ms += std::abs(static_cast<double>((st.actual - st.predicted).count())) / 1000.0;
+                }
+                actual = ctrl.get_current_position();
+                ok = rc == 0 && std::abs(actual - expected) <= cfg.tolerance;
+                break;
+            }
+            case action::relative_polled: {
+                expected = std::max(0, before + s.value);
+                const auto sent = steady_clock::now();
+                ctrl.move_relative(s.value, s.speed);
+                while (steady_clock::now() - sent < milliseconds(cfg.settle_timeout_ms)) {
+                    std::this_thread::sleep_for(milliseconds(120));
+                    actual = ctrl.get_current_position();
+                    if (std::abs(actual - expected) <= cfg.tolerance) break;
+                }
+                ok = std::abs(actual - expected) <= cfg.tolerance;
+                if (ok) took = duration_cast<microseconds>(steady_clock::now() - sent);
+                break;
+            }
+            case action::reconnect: {
+                const std::string port = ctrl.get_port_name(); // cleared by disconnect()
+                ctrl.disconnect();
+                std::this_thread::sleep_for(s.dwell);
+                const auto start = steady_clock::now();
+                rc = ctrl.connect(port);
+                ok = rc == 0 && ctrl.is_connected();
+                if (ok) took = duration_cast<microseconds>(steady_clock::now() - start);
+                break;
+            }
+            }
+            if (took) {
+                settle.record(*took);
+                all.record(*took);
+            }
+            if (s.kind != action::reconnect && s.dwell.count() > 0) std::this_thread::sleep_for(s.dwell);
 
-        if ((i + 1) % 100 == 0) {
-            std::cout << "[progress] " << (i + 1) << "/" << iterations
-                      << " pass=" << pass << " fail=" << fail << std::endl;
+            ++out.steps;
+            if (ok) ++out.pass;
+            else ++out.fail;
+            if (!ok && cfg.log_failures) {
+                std::lock_guard<std::mutex> lk(print_mutex);
+                if (s.kind == action::absolute)
+                    std::cout << "[abs-fail] i=" << i << " target=" << s.value;
+                else if (s.kind == action::reconnect)
+                    std::cout << "[conn-fail] i=" << i;
+                else
+                    std::cout << "[fail] i=" << i << " before=" << before << " delta=" << s.value << " speed=" << s.speed;
+                if (s.kind == action::reconnect)
+                    std::cout << " rc=" << rc << " state=" << ctrl.is_connected();
+                else
+                    std::cout << " expected=" << expected << " got=" << actual << " rc=" << rc;
+                std::cout << " arm=" << index << std::endl;
+            }
+            if (cfg.progress_every > 0 && (i + 1) % cfg.progress_every == 0) {
+                std::lock_guard<std::mutex> lk(print_mutex);
+                std::cout << progress_tag(work.op) << " " << (i + 1) << "/" << cfg.iterations
+                          << " pass=" << out.pass << " fail=" << out.fail << " arm=" << index << std::endl;
+            }
         }
+        out.seconds = duration<double>(steady_clock::now() - t0).count();
+        out.steps_per_second = out.seconds > 0 ? out.steps / out.seconds : 0.0;
+        out.settle = settle.get();
+        out.mean_abs_error_ms = out.predicted > 0 ? abs_error_ms / out.predicted : 0.0;
+        out.metrics = ctrl.metrics_since(*base);
+        if (out.seconds > 0)
+            out.bus_utilization = static_cast<double>(out.metrics.transaction.total.count()) / (out.seconds * 1e6);
     }
+};
+
+// The single-arm entry points, as stress_engine workloads. They keep their summary lines
+// for existing logs, then print the engine's report. Fixed seed: rerun with another one
+// to vary the sequence.
+
+// Randomized stress test for move_relative (+/-) with verification via get_current_position
+static stress_engine::report stress_test_move_relative_blocking(act_controller& ctrl,
+                                                                int iterations,
+                                                                int min_pos,
+                                                                int max_pos,
+                                                                int max_step,
+                                                                int settle_timeout_ms = 1500,
+                                                                int tolerance = 1,
+                                                                uint32_t seed = 1) {
+    stress_engine::config cfg;
+    cfg.iterations = iterations;
+    cfg.seed = seed;
+    cfg.settle_timeout_ms = settle_timeout_ms;
+    cfg.tolerance = tolerance;
+    const stress_engine::report r =
+        stress_engine::run({&ctrl}, stress_engine::random_relative(min_pos, max_pos, max_step), cfg);
+    const stress_engine::arm_report& a = r.arms.front();
+    std::cout << "[summary] iterations=" << iterations
+              << " pass=" << r.pass << " fail=" << r.fail << std::endl;
+    std::cout << "[settle] polls/move=" << (iterations > 0 ? static_cast<double>(a.polls) / iterations : 0.0)
+              << " predicted=" << a.predicted
+              << " mean|actual-predicted|ms=" << a.mean_abs_error_ms
+              << " overhead_ms=" << ctrl.estimator().overhead_ms()
+              << " slope_ms=" << ctrl.estimator().slope_ms() << std::endl;
+    stress_engine::print(r);
+    return r;
+}
+
+// Randomized stress test for move_relative within a position range [min_pos, max_pos]
+static stress_engine::report stress_test_move_relative(act_controller& ctrl,
+                                                       int iterations,
+                                                       int min_pos,
+                                                       int max_pos,
+                                                       int max_step,
+                                                       int settle_timeout_ms = 1500,
+                                                       int tolerance = 1,
+                                                       uint32_t seed = 1) {
+    stress_engine::config cfg;
+    cfg.iterations = iterations;
+    cfg.seed = seed;
+    cfg.settle_timeout_ms = settle_timeout_ms;
+    cfg.tolerance = tolerance;
+    const stress_engine::report r =
+        stress_engine::run({&ctrl}, stress_engine::random_relative(min_pos, max_pos, max_step, true), cfg);
     std::cout << "[summary] iterations=" << iterations
-              << " pass=" << pass << " fail=" << fail << std::endl;
+              << " pass=" << r.pass << " fail=" << r.fail << std::endl;
+    stress_engine::print(r);
+    return r;
 }
 
 // Randomized stress test for absolute movement within a position range [min_pos, max_pos]
 // Uses move_absolute_blocking for each target and verifies via get_current_position.
 // Reduced tolerance default (0).
-static void stress_test_move_absolute_blocking(act_controller& ctrl,
-                                      int iterations,
-                                      int min_pos,
-                                      int max_pos,
-                                      int settle_timeout_ms = 1500,
-                                      int tolerance = 0) {
-    using namespace std::chrono;
-    if (min_pos > max_pos) std::swap(min_pos, max_pos);
-    if (min_pos < 0) min_pos = 0;
-
-    std::mt19937 rng(static_cast<unsigned int>(steady_clock::now().time_since_epoch().count()));
-    std::uniform_int_distribution<int> target_dist(min_pos, max_pos);
-    std::uniform_int_distribution<int> spd_dist(1, 30); // added
-
-    int pass = 0, fail = 0;
-    for (int i = 0; i < iterations; ++i) {
-        int target = target_dist(rng);
-        int expected = std::clamp(target, min_pos, max_pos);
-
-        // Convert ms to seconds (ceil), minimum 1s
-        int timeout_sec = std::max(1, (settle_timeout_ms + 999) / 1000);
-        int speed = spd_dist(rng); // added
-        int rc = ctrl.move_absolute_blocking(expected, speed, timeout_sec, tolerance);
-
-        // Verify final position
-        int actual = ctrl.get_current_position();
-        bool ok = (rc == 0) && (std::abs(actual - expected) <= tolerance);
-
-        if (ok) {
-            ++pass;
-        } else {
-            ++fail;
-            std::cout << "[abs-fail] i=" << i
-                      << " target=" << target
-                      << " expected=" << expected
-                      << " got=" << actual
-                      << " rc=" << rc << std::endl;
-        }
-
-        if ((i + 1) % 100 == 0) {
-            std::cout << "[abs-progress] " << (i + 1) << "/" << iterations
-                      << " pass=" << pass << " fail=" << fail << std::endl;
-        }
-    }
+static stress_engine::report stress_test_move_absolute_blocking(act_controller& ctrl,
+                                                                int iterations,
+                                                                int min_pos,
+                                                                int max_pos,
+                                                                int settle_timeout_ms = 1500,
+                                                                int tolerance = 0,
+                                                                uint32_t seed = 1) {
+    stress_engine::config cfg;
+    cfg.iterations = iterations;
+    cfg.seed = seed;
+    cfg.settle_timeout_ms = settle_timeout_ms;
+    cfg.tolerance = tolerance;
+    const stress_engine::report r =
+        stress_engine::run({&ctrl}, stress_engine::random_absolute(min_pos, max_pos), cfg);
     std::cout << "[abs-summary] iterations=" << iterations
-              << " pass=" << pass << " fail=" << fail << std::endl;
+              << " pass=" << r.pass << " fail=" << r.fail << std::endl;
+    stress_engine::print(r);
+    return r;
 }
 
-// Repeated connect / disconnect stress test
-static void stress_test_connect_disconnect(act_controller& ctrl,
-                                           int iterations,
-                                           int delay_ms = 50,
-                                           const std::string& explicit_port = std::string()) {
-    if (!explicit_port.empty()) {
-        ctrl.disconnect();
+// Repeated connect / disconnect stress test: connect (to explicit_port if given), then
+// reconnect to the same port `iterations` times. Ends disconnected.
+static stress_engine::report stress_test_connect_disconnect(act_controller& ctrl,
+                                                            int iterations,
+                                                            int delay_ms = 50,
+                                                            const std::string& explicit_port = std::string()) {
+    if (!explicit_port.empty()) ctrl.disconnect();
+    if (!ctrl.is_connected()) {
         int rc = ctrl.connect(explicit_port);
         if (rc == 0 && ctrl.is_connected()) {
             std::string actual = ctrl.get_port_name();
-            if (actual != explicit_port)
+            if (!explicit_port.empty() && actual != explicit_port)
                 std::cout << "[connect-ok] requested=" << explicit_port << " actual=" << actual << std::endl;
             else
                 std::cout << "[connect-ok] " << actual << std::endl;
-            ctrl.disconnect();
         } else {
             std::cout << "[connect-fail] " << explicit_port << " rc=" << rc << std::endl;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-    }
-    int pass = 0, fail = 0;
-    for (int i = 0; i < iterations; ++i) {
-        // Ensure starting disconnected
-        if (ctrl.is_connected()) {
-            ctrl.disconnect();
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-        }
-        int rc = ctrl.connect();
-        bool ok_connect = (rc == 0 && ctrl.is_connected());
-        if (!ok_connect) {
-            ++fail;
-            std::cout << "[conn-fail] i=" << i << " rc=" << rc
-                      << " state=" << ctrl.is_connected() << std::endl;
-            continue;
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-        ctrl.disconnect();
-        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-        bool ok_disconnect = !ctrl.is_connected();
-        if (ok_disconnect) ++pass;
-        else {
-            ++fail;
-            std::cout << "[disc-fail] i=" << i << " state=" << ctrl.is_connected() << std::endl;
-        }
-        if ((i + 1) % 100 == 0) {
-            std::cout << "[conn-progress] " << (i + 1) << "/" << iterations
-                      << " pass=" << pass << " fail=" << fail << std::endl;
-        }
     }
+    stress_engine::config cfg;
+    cfg.iterations = iterations;
+    const stress_engine::report r =
+        stress_engine::run({&ctrl}, stress_engine::connect_churn(std::chrono::milliseconds(delay_ms)), cfg);
+    ctrl.disconnect();
     if (iterations > 0) {
         std::cout << "[conn-summary] iterations=" << iterations
-                  << " pass=" << pass << " fail=" << fail << std::endl;
+                  << " pass=" << r.pass << " fail=" << r.fail << std::endl;
     }
+    stress_engine::print(r);
+    return r;
 }
 
 #ifndef ACT_CONTROLLER_NO_MAIN
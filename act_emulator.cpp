@@ -0,0 +1,330 @@
+// Controller emulator on a pseudo-terminal.
+// Opens a pty pair and answers, on the master side, the Modbus RTU frames act_controller
+// sends to the slave side, so connect("/dev/pts/N"), the moves and the stress tests run
+// unchanged over a real tty. Register behaviour and travel time come from
+// act_controller::simulated_actuator; the emulator adds the wire time of each frame at the
+// line's rate and optional faults (dropped bytes, bad CRC, silence).
+//
+//   act_emulator [--slave N] [--baud N] [--latency-us N] [--units-per-second X]
+//                [--move-overhead-ms N] [--start POS] [--no-wire-delay]
+//                [--drop P] [--bad-crc P] [--silence P] [--seed N] [--link PATH]
+//
+// Prints the slave device name, then serves until SIGINT/SIGTERM. SIGUSR1 toggles a
+// silent drive (no replies at all) for reconnect tests.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <system_error>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include <csignal>
+#endif
+
+#ifndef ACT_CONTROLLER_NO_MAIN
+#define ACT_CONTROLLER_NO_MAIN
+#endif
+#include "act_controller.cpp"
+
+#ifndef _WIN32
+class pty_emulator {
+public:
+    // Each reply independently: one byte dropped, its CRC corrupted, or not sent at all.
+    struct faults {
+        double drop_byte = 0.0;
+        double bad_crc = 0.0;
+        double silence = 0.0;
+        uint32_t seed = 1;
+    };
+
+    struct options {
+        act_controller::simulated_actuator::params drive;
+        // The drive's line rate. 0 answers at whatever rate the client set; otherwise
+        // requests sent at another rate are treated as line noise, as on a real drive.
+        unsigned baud = 0;
+        bool wire_delay = true;
+        faults fault;
+    };
+
+    struct stats {
+        uint64_t requests = 0;      // complete frames with a good CRC
+        uint64_t replies = 0;       // replies written, faulty ones included
+        uint64_t noise_bytes = 0;   // bytes skipped while looking for a frame
+        uint64_t dropped_bytes = 0;
+        uint64_t bad_crcs = 0;
+        uint64_t silenced = 0;
+    };
+
+    pty_emulator() : pty_emulator(options()) {}
+
+    // Throws std::system_error if no pty pair can be opened.
+    explicit pty_emulator(const options& opt)
+        : opt_(opt), drive_(std::make_shared<act_controller::simulated_actuator>(drive_params(opt))),
+          rng_(opt.fault.seed) {
+        master_ = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (master_ < 0 || ::grantpt(master_) != 0 || ::unlockpt(master_) != 0) {
+            const int err = errno;
+            if (master_ >= 0) ::close(master_);
+            throw std::system_error(err, std::generic_category(), "posix_openpt");
+        }
+        name_ = ::ptsname(master_);
+        // Holding the slave open keeps the master readable across client reconnects and
+        // gives us the line settings the client applied.
+        keep_ = ::open(name_.c_str(), O_RDWR | O_NOCTTY);
+        termios tio{};
+        ::tcgetattr(keep_, &tio);
+        ::cfmakeraw(&tio);
+        ::tcsetattr(keep_, TCSANOW, &tio);
+        th_ = std::thread([this] { loop(); });
+    }
+
+    ~pty_emulator() {
+        stop_ = true;
+        if (th_.joinable()) th_.join();
+        if (keep_ >= 0) ::close(keep_);
+        if (master_ >= 0) ::close(master_);
+    }
+
+    pty_emulator(const pty_emulator&) = delete;
+    pty_emulator& operator=(const pty_emulator&) = delete;
+
+    // The device to pass to act_controller::connect().
+    const std::string& port() const { return name_; }
+
+    // The thread answering requests (benchmarks leave its allocations out of their counts).
+    std::thread::id thread_id() const { return th_.get_id(); }
+
+    // The emulated drive: position, moves, travel parameters, silence.
+    act_controller::simulated_actuator& drive() { return *drive_; }
+
+    void set_faults(const faults& f) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        opt_.fault = f;
+        rng_.seed(f.seed);
+    }
+
+    stats get_stats() const {
+        std::lock_guard<std::mutex> lk(mutex_);
+        return stats_;
+    }
+
+private:
+    struct pending {
+        std::chrono::steady_clock::time_point due;
+        std::vector<uint8_t> bytes;
+    };
+
+    static act_controller::simulated_actuator::params drive_params(const options& opt) {
+        act_controller::simulated_actuator::params p = opt.drive;
+        p.wire_delay = opt.wire_delay;
+        return p;
+    }
+
+    // The rate the client configured on the slave side, 0 if not a standard one.
+    unsigned line_baud() const {
+        termios tio{};
+        if (::tcgetattr(keep_, &tio) != 0) return 0;
+        switch (::cfgetospeed(&tio)) {
+        case B9600: return 9600;
+        case B19200: return 19200;
+        case B38400: return 38400;
+        case B57600: return 57600;
+        case B115200: return 115200;
+        case B230400: return 230400;
+        default: return 0;
+        }
+    }
+
+    // Length of the request frame at the front of buf, 0 if it is not complete yet.
+    static std::size_t request_length(const std::vector<uint8_t>& buf) {
+        if (buf.size() < 8) return 0;
+        const uint8_t func = buf[1];
+        const std::size_t len = (func == 0x0F || func == 0x10) ? 9u + buf[6] : 8u;
+        return buf.size() >= len ? len : 0;
+    }
+
+    // Serve one request; frames from other slaves or at the wrong rate get nothing.
+    void serve(const uint8_t* req, std::size_t len, std::chrono::steady_clock::time_point now) {
+        const unsigned line = line_baud();
+        if (opt_.baud != 0 && line != opt_.baud) {
+            std::lock_guard<std::mutex> lk(mutex_);
+            stats_.noise_bytes += len;
+            return;
+        }
+        uint8_t out[260];
+        std::chrono::microseconds delay{0};
+        const std::size_t n = drive_->handle(req, len, out, now, delay);
+        std::lock_guard<std::mutex> lk(mutex_);
+        ++stats_.requests;
+        if (n == 0) return;
+        // The request only reaches a real drive after its own wire time
+        const unsigned baud = line ? line : act_controller::k_default_baud;
+        pending p;
+        p.due = now + delay + drive_->wire_delay(len + n, baud);
+        p.bytes.assign(out, out + n);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        if (u(rng_) < opt_.fault.silence) {
+            ++stats_.silenced;
+            return;
+        }
+        if (u(rng_) < opt_.fault.bad_crc) {
+            p.bytes.back() ^= 0x5A;
+            ++stats_.bad_crcs;
+        }
+        if (u(rng_) < opt_.fault.drop_byte) {
+            p.bytes.erase(p.bytes.begin() + std::uniform_int_distribution<std::size_t>(0, n - 1)(rng_));
+            ++stats_.dropped_bytes;
+        }
+        queue_.push_back(std::move(p));
+    }
+
+    void loop() {
+        using namespace std::chrono;
+        std::vector<uint8_t> buf;
+        while (!stop_) {
+            int wait_ms = 20;
+            {
+                std::lock_guard<std::mutex> lk(mutex_);
+                if (!queue_.empty()) {
+                    const auto left = duration_cast<milliseconds>(queue_.front().due - steady_clock::now());
+                    wait_ms = static_cast<int>(std::clamp<long long>(left.count(), 0, 20));
+                }
+            }
+            pollfd pfd{master_, POLLIN, 0};
+            if (::poll(&pfd, 1, wait_ms) > 0 && (pfd.revents & POLLIN)) {
+                uint8_t tmp[256];
+                const ssize_t n = ::read(master_, tmp, sizeof(tmp));
+                if (n > 0) buf.insert(buf.end(), tmp, tmp + n);
+            }
+            const auto now = steady_clock::now();
+            while (std::size_t len = request_length(buf)) {
+                if (modbus::crc16(buf.data(), len) != 0) {
+                    // Not a frame boundary: slide one byte and look again
+                    buf.erase(buf.begin());
+                    std::lock_guard<std::mutex> lk(mutex_);
+                    ++stats_.noise_bytes;
+                    continue;
+                }
+                serve(buf.data(), len, now);
+                buf.erase(buf.begin(), buf.begin() + static_cast<std::ptrdiff_t>(len));
+            }
+            flush(steady_clock::now());
+        }
+    }
+
+    // Write every reply that is due; spin out the last sub-millisecond of a wait.
+    void flush(std::chrono::steady_clock::time_point now) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        while (!queue_.empty()) {
+            pending& p = queue_.front();
+            if (p.due > now) {
+                if (p.due - now > std::chrono::milliseconds(1)) return;
+                while (std::chrono::steady_clock::now() < p.due) std::this_thread::yield();
+            }
+            (void)!::write(master_, p.bytes.data(), p.bytes.size());
+            ++stats_.replies;
+            queue_.pop_front();
+            now = std::chrono::steady_clock::now();
+        }
+    }
+
+    options opt_;
+    std::shared_ptr<act_controller::simulated_actuator> drive_;
+    mutable std::mutex mutex_;
+    std::mt19937 rng_;
+    std::deque<pending> queue_;
+    stats stats_;
+    int master_ = -1;
+    int keep_ = -1;
+    std::string name_;
+    std::atomic<bool> stop_{false};
+    std::thread th_;
+};
+#endif
+
+#ifndef ACT_EMULATOR_NO_MAIN
+#ifndef _WIN32
+static volatile std::sig_atomic_t g_quit = 0;
+static volatile std::sig_atomic_t g_toggle_silence = 0;
+
+int main(int argc, char** argv) {
+    pty_emulator::options opt;
+    std::string link;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        auto need = [&]() -> const char* {
+            if (!v) {
+                std::cerr << "[emulator] " << a << " needs a value" << std::endl;
+                std::exit(2);
+            }
+            ++i;
+            return v;
+        };
+        if (a == "--slave") opt.drive.slave = static_cast<uint8_t>(std::stoi(need()));
+        else if (a == "--baud") opt.baud = static_cast<unsigned>(std::stoul(need()));
+        else if (a == "--latency-us") opt.drive.reply_latency = std::chrono::microseconds(std::stol(need()));
+        else if (a == "--units-per-second") opt.drive.units_per_second = std::stod(need());
+        else if (a == "--move-overhead-ms") opt.drive.move_overhead = std::chrono::milliseconds(std::stol(need()));
+        else if (a == "--start") opt.drive.start_raw = static_cast<int16_t>(std::stoi(need()) * 100);
+        else if (a == "--no-wire-delay") opt.wire_delay = false;
+        else if (a == "--drop") opt.fault.drop_byte = std::stod(need());
+        else if (a == "--bad-crc") opt.fault.bad_crc = std::stod(need());
+        else if (a == "--silence") opt.fault.silence = std::stod(need());
+        else if (a == "--seed") opt.fault.seed = static_cast<uint32_t>(std::stoul(need()));
+        else if (a == "--link") link = need();
+        else {
+            std::cerr << "[emulator] unknown option " << a << std::endl;
+            return 2;
+        }
+    }
+
+    std::signal(SIGINT, [](int) { g_quit = 1; });
+    std::signal(SIGTERM, [](int) { g_quit = 1; });
+    std::signal(SIGUSR1, [](int) { g_toggle_silence = 1; });
+
+    pty_emulator emu(opt);
+    if (!link.empty()) {
+        ::unlink(link.c_str());
+        if (::symlink(emu.port().c_str(), link.c_str()) != 0)
+            std::cerr << "[emulator] cannot link " << link << std::endl;
+    }
+    std::cout << "[emulator] port=" << emu.port() << (link.empty() ? "" : " link=" + link)
+              << " slave=" << static_cast<int>(opt.drive.slave)
+              << " baud=" << (opt.baud ? std::to_string(opt.baud) : "any") << std::endl;
+
+    bool silent = false;
+    while (!g_quit) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (g_toggle_silence) {
+            g_toggle_silence = 0;
+            silent = !silent;
+            emu.drive().set_silent(silent);
+            std::cout << "[emulator] silent=" << silent << std::endl;
+        }
+    }
+    if (!link.empty()) ::unlink(link.c_str());
+
+    const pty_emulator::stats st = emu.get_stats();
+    std::cout << "[emulator] requests=" << st.requests << " replies=" << st.replies
+              << " moves=" << emu.drive().moves() << " position=" << emu.drive().position()
+              << " noise_bytes=" << st.noise_bytes << " dropped_bytes=" << st.dropped_bytes
+              << " bad_crcs=" << st.bad_crcs << " silenced=" << st.silenced << std::endl;
+    return 0;
+}
+#else
+int main() {
+    std::cerr << "[emulator] needs a POSIX pty" << std::endl;
+    return 1;
+}
+#endif
+#endif // ACT_EMULATOR_NO_MAIN
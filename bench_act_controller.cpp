@@ -0,0 +1,408 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <map>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#define ACT_EMULATOR_NO_MAIN
+#include "act_emulator.cpp"
+
+// Keeps the optimizer from discarding benchmarked results
+static volatile uint16_t bench_sink;
+
+// Heap allocations while g_count_allocs is set, on every thread but g_alloc_exempt (the
+// emulator's), for the allocs/op column.
+static std::atomic<bool> g_count_allocs{false};
+static std::atomic<uint64_t> g_allocs{0};
+static std::thread::id g_alloc_exempt;
+
+[[gnu::noinline]] void* operator new(std::size_t n) {
+    if (g_count_allocs.load(std::memory_order_relaxed) && std::this_thread::get_id() != g_alloc_exempt)
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// One suite entry: printed as a [bench] line and, with --json, written as one JSON object
+// per line so runs from different commits can be diffed or fed to --compare.
+struct bench_result {
+    std::string name;
+    uint64_t ops = 0;
+    double ops_per_sec = 0;
+    double p50_ns = 0;
+    double p99_ns = 0;
+    double max_ns = 0;
+    double allocs_per_op = 0;
+};
+
+static std::vector<bench_result> g_results;
+static double g_budget_scale = 1.0; // --quick shortens every run
+static int g_failed_cases = 0;       // cases dropped because an op failed
+
+// Run op() for about `budget` after a warm-up, in batches of `batch` calls, and for at
+// least `min_samples` batches (scaled by --quick, never below 3). Each batch is one latency
+// sample (batch time / batch), so nanosecond-scale ops are not swamped by clock reads;
+// cycles use batch 1. An op returning bool reports failure with false: a case with any
+// failed op is reported as failed and left out of the results.
+template <typename F>
+static void run_bench(const std::string& name, std::size_t batch, std::chrono::milliseconds budget, F&& op,
+                      std::size_t min_samples = 1) {
+    using clock = std::chrono::steady_clock;
+    const auto limit = std::chrono::duration_cast<clock::duration>(budget * g_budget_scale);
+    if (min_samples > 1)
+        min_samples = std::max<std::size_t>(3, static_cast<std::size_t>(static_cast<double>(min_samples) * g_budget_scale));
+    uint64_t failed = 0;
+    auto call = [&] {
+        if constexpr (std::is_same_v<decltype(op()), bool>) {
+            if (!op()) ++failed;
+        } else {
+            op();
+        }
+    };
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, batch / 4); ++i) call();
+    std::vector<double> ns;
+    uint64_t ops = 0;
+    g_allocs = 0;
+    g_count_allocs = true;
+    const auto t0 = clock::now();
+    auto t = t0;
+    do {
+        const auto b0 = clock::now();
+        for (std::size_t i = 0; i < batch; ++i) call();
+        t = clock::now();
+        ns.push_back(std::chrono::duration<double, std::nano>(t - b0).count() / static_cast<double>(batch));
+        ops += batch;
+    } while (t - t0 < limit || ns.size() < min_samples);
+    g_count_allocs = false;
+    if (failed > 0) {
+        std::cout << "[bench] " << std::left << std::setw(32) << name << std::right << " FAILED "
+                  << failed << " of " << ops + std::max<std::size_t>(1, batch / 4) << " ops, not reported" << std::endl;
+        ++g_failed_cases;
+        return;
+    }
+    std::sort(ns.begin(), ns.end());
+    bench_result r;
+    r.name = name;
+    r.ops = ops;
+    r.ops_per_sec = static_cast<double>(ops) / std::chrono::duration<double>(t - t0).count();
+    r.p50_ns = ns[ns.size() / 2];
+    r.p99_ns = ns[std::min(ns.size() - 1, ns.size() * 99 / 100)];
+    r.max_ns = ns.back();
+    r.allocs_per_op = static_cast<double>(g_allocs.load()) / static_cast<double>(ops);
+    std::cout << "[bench] " << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(1)
+              << " ops/s=" << std::setw(12) << r.ops_per_sec << " p50_ns=" << std::setw(10) << r.p50_ns
+              << " p99_ns=" << std::setw(10) << r.p99_ns << " max_ns=" << std::setw(10) << r.max_ns
+              << std::setprecision(2) << " allocs/op=" << r.allocs_per_op << std::defaultfloat << std::endl;
+    g_results.push_back(r);
+}
+
+// Frame building, CRC and reply parsing: the per-command CPU work, no I/O.
+static void bench_hot_paths() {
+    using namespace std::chrono;
+    // The controller's own builders: constant frame, runtime fields patched, CRC resealed
+    const auto k_rel = act_controller::relative_move_frame(1, 10);
+    int i = 0;
+    run_bench("frame_relative_move", 1024, milliseconds(200), [&] {
+        ++i;
+        const auto f = act_controller::relative_move_frame(i & 1 ? -(i & 63) - 1 : (i & 63) + 1, i & 31);
+        bench_sink = f[f.size() - 1];
+    });
+    run_bench("frame_absolute_params", 1024, milliseconds(200), [&] {
+        ++i;
+        const auto f = act_controller::absolute_params_frame(i & 511, i & 31);
+        bench_sink = f[f.size() - 1];
+    });
+    run_bench("frame_readdress", 1024, milliseconds(200), [&] {
+        auto f = k_rel.bytes;
+        modbus::readdress(f.data(), f.size(), static_cast<uint8_t>(2 + (++i & 7)));
+        bench_sink = f.back();
+    });
+
+    const auto req = modbus::read_holding(0x01, 0x9000, 0x0002);
+    run_bench("crc16_modbus_8B", 1024, milliseconds(200), [&] { bench_sink = modbus::crc16_fast(req.data(), req.size()); });
+    run_bench("crc16_modbus_41B", 1024, milliseconds(200), [&] { bench_sink = modbus::crc16_fast(k_rel.data(), k_rel.size()); });
+
+    // A two-register status reply, whole and in the pieces a USB adapter hands over
+    uint8_t reply[9] = {0x01, 0x03, 0x04, 0x00, 0x02, 0x09, 0xc4};
+    const uint16_t crc = modbus::crc16(reply, 7);
+    reply[7] = static_cast<uint8_t>(crc & 0xFF);
+    reply[8] = static_cast<uint8_t>(crc >> 8);
+    modbus::rtu_parser parser;
+    run_bench("parse_status_reply", 1024, milliseconds(200), [&] {
+        const uint8_t* f = nullptr;
+        parser.feed(reply, sizeof(reply));
+        bench_sink = static_cast<uint16_t>(parser.next(&f));
+    });
+    run_bench("parse_status_reply_chunked", 1024, milliseconds(200), [&] {
+        const uint8_t* f = nullptr;
+        parser.feed(reply, 3);
+        (void)parser.next(&f);
+        parser.feed(reply + 3, 4);
+        (void)parser.next(&f);
+        parser.feed(reply + 7, 2);
+        bench_sink = static_cast<uint16_t>(parser.next(&f));
+    });
+}
+
+// Full API cycles against a connected controller: position reads and blocking moves
+// back and forth from position 10 (a failed read returns 0, so a read is checked against
+// it). Moves take 100-500 ms (their frame pauses), so they run to a sample count instead
+// of a time budget.
+static void bench_cycles(const std::string& prefix, act_controller& ctrl) {
+    using namespace std::chrono;
+    if (ctrl.move_absolute_blocking(10, 30, 2, 0) != 0) {
+        std::cout << "[bench] " << prefix << "cycles: move to the start position failed" << std::endl;
+        ++g_failed_cases;
+        return;
+    }
+    run_bench(prefix + "get_current_position", 1, milliseconds(500), [&] { return ctrl.get_current_position() == 10; });
+    int dir = 1;
+    run_bench(prefix + "move_relative_blocking", 1, milliseconds(0), [&] {
+        const bool ok = ctrl.move_relative_blocking(dir, 30, 2, 0) == 0;
+        dir = -dir;
+        return ok;
+    }, 20);
+    int target = 10;
+    run_bench(prefix + "move_absolute_blocking", 1, milliseconds(0), [&] {
+        const bool ok = ctrl.move_absolute_blocking(target, 30, 2, 0) == 0;
+        target = target == 10 ? 11 : 10;
+        return ok;
+    }, 20);
+}
+
+// The software path alone: an in-process simulated drive, travel at 10^6 units/s.
+static void bench_cycles_sim() {
+    act_controller::simulated_actuator::params p;
+    p.units_per_second = 1e6;
+    act_controller ctrl(act_controller::simulated(std::make_shared<act_controller::simulated_actuator>(p)));
+    ctrl.set_status_bits({0x0001, 0x0002, 0x0004});
+    if (ctrl.connect("sim") != 0) {
+        std::cout << "[bench] sim connect failed" << std::endl;
+        return;
+    }
+    bench_cycles("sim_", ctrl);
+    ctrl.disconnect();
+}
+
+#ifndef _WIN32
+// Through a real tty: the pty emulator without wire delay, travel at 10^6 units/s.
+static void bench_cycles_pty() {
+    pty_emulator::options opt;
+    opt.wire_delay = false;
+    opt.drive.units_per_second = 1e6;
+    pty_emulator emu(opt);
+    g_alloc_exempt = emu.thread_id();
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    ctrl.set_status_bits({0x0001, 0x0002, 0x0004});
+    if (ctrl.connect(emu.port()) != 0) {
+        std::cout << "[bench] pty connect failed" << std::endl;
+        return;
+    }
+    bench_cycles("pty_", ctrl);
+    ctrl.disconnect();
+    g_alloc_exempt = std::thread::id();
+}
+#endif
+
+static void write_json(const std::string& path, const std::string& label) {
+    std::ofstream out(path, std::ios::app);
+    out << std::setprecision(6);
+    for (const auto& r : g_results)
+        out << "{\"label\":\"" << label << "\",\"name\":\"" << r.name << "\",\"ops\":" << r.ops
+            << ",\"ops_per_sec\":" << r.ops_per_sec << ",\"p50_ns\":" << r.p50_ns << ",\"p99_ns\":" << r.p99_ns
+            << ",\"max_ns\":" << r.max_ns << ",\"allocs_per_op\":" << r.allocs_per_op << "}\n";
+}
+
+// Numeric field of one of our own JSON lines.
+static double json_number(const std::string& line, const std::string& key) {
+    const std::size_t at = line.find("\"" + key + "\":");
+    return at == std::string::npos ? 0.0 : std::atof(line.c_str() + at + key.size() + 3);
+}
+
+// p50 and throughput of this run against an earlier --json file (its last entry per name).
+static void compare_with(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "[bench-compare] cannot read " << path << std::endl;
+        return;
+    }
+    std::map<std::string, std::pair<double, double>> base;
+    for (std::string line; std::getline(in, line);) {
+        const std::size_t a = line.find("\"name\":\"");
+        if (a == std::string::npos) continue;
+        const std::size_t b = line.find('"', a + 8);
+        base[line.substr(a + 8, b - a - 8)] = {json_number(line, "p50_ns"), json_number(line, "ops_per_sec")};
+    }
+    for (const auto& r : g_results) {
+        const auto it = base.find(r.name);
+        if (it == base.end() || it->second.first <= 0 || it->second.second <= 0) continue;
+        std::cout << "[bench-compare] " << std::left << std::setw(32) << r.name << std::right << std::fixed
+                  << std::setprecision(2) << " p50 x" << r.p50_ns / it->second.first
+                  << " ops/s x" << r.ops_per_sec / it->second.second << std::defaultfloat << std::endl;
+    }
+}
+
+// CRC16 throughput per engine, from single frames up to 64 KiB capture buffers
+static void bench_crc16() {
+    using clock = std::chrono::steady_clock;
+    const std::size_t sizes[] = {8, 41, 256, 1024, 4096, 16384, 65536};
+    const modbus::crc16_engine engines[] = {
+        modbus::crc16_engine::bitwise, modbus::crc16_engine::table,
+        modbus::crc16_engine::slice8, modbus::crc16_engine::clmul};
+
+    std::vector<uint8_t> buf(65536 + 1);
+    std::mt19937 rng(12345);
+    for (auto& b : buf) b = static_cast<uint8_t>(rng());
+    // Offset by one byte so no engine benefits from an aligned buffer
+    const uint8_t* data = buf.data() + 1;
+
+    std::cout << "[crc-bench] best=" << modbus::crc16_engine_name(modbus::crc16_best_engine()) << std::endl;
+    for (auto e : engines) {
+        if (!modbus::crc16_engine_supported(e)) {
+            std::cout << "[crc-bench] engine=" << modbus::crc16_engine_name(e) << " skipped (unsupported)" << std::endl;
+            continue;
+        }
+        for (std::size_t n : sizes) {
+            if (modbus::crc16_with(e, data, n) != modbus::crc16(data, n)) {
+                std::cout << "[crc-bench] engine=" << modbus::crc16_engine_name(e) << " MISMATCH bytes=" << n << std::endl;
+                continue;
+            }
+            // Run for ~50 ms per point, in batches to keep clock reads off the measurement
+            const std::size_t batch = std::max<std::size_t>(1, 65536 / n);
+            std::size_t iters = 0;
+            const auto t0 = clock::now();
+            auto t1 = t0;
+            do {
+                for (std::size_t i = 0; i < batch; ++i) bench_sink = modbus::crc16_with(e, data, n);
+                iters += batch;
+                t1 = clock::now();
+            } while (t1 - t0 < std::chrono::milliseconds(50));
+            const double sec = std::chrono::duration<double>(t1 - t0).count();
+            const double bps = static_cast<double>(iters) * static_cast<double>(n) / sec;
+            std::cout << "[crc-bench] engine=" << std::left << std::setw(8) << modbus::crc16_engine_name(e)
+                      << " bytes=" << std::setw(6) << n
+                      << " MB/s=" << std::fixed << std::setprecision(1) << bps / 1e6
+                      << " ns/frame=" << std::setprecision(1) << sec * 1e9 / static_cast<double>(iters)
+                      << std::defaultfloat << std::right << std::endl;
+        }
+    }
+}
+
+// Wall-clock status read round trip with the low-latency mode off, then on. Runs
+// against the pty emulator, without its wire delay so only the software and tty path
+// is measured, unless a device path is given.
+static void bench_rtt(const std::string& device) {
+    using clock = std::chrono::steady_clock;
+#ifndef _WIN32
+    std::unique_ptr<pty_emulator> pty;
+    std::string port = device;
+    if (port.empty()) {
+        pty_emulator::options opt;
+        opt.wire_delay = false;
+        pty = std::make_unique<pty_emulator>(opt);
+        port = pty->port();
+    }
+#else
+    const std::string port = device;
+    if (port.empty()) {
+        std::cout << "[rtt-bench] skipped (no device given)" << std::endl;
+        return;
+    }
+#endif
+    for (bool low_latency : {false, true}) {
+        act_controller ctrl;
+        ctrl.set_port_cache_path("");
+        act_controller::line_settings line;
+        line.low_latency = low_latency;
+        ctrl.set_line_settings(line);
+        if (ctrl.connect(port) != 0) {
+            std::cout << "[rtt-bench] connect to " << port << " failed" << std::endl;
+            return;
+        }
+        for (int i = 0; i < 50; ++i) (void)ctrl.read_status();
+        std::vector<long long> us;
+        us.reserve(2000);
+        int failed = 0;
+        for (int i = 0; i < 2000; ++i) {
+            const auto t0 = clock::now();
+            if (ctrl.read_status().timestamp == clock::time_point()) ++failed;
+            us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - t0).count());
+        }
+        std::sort(us.begin(), us.end());
+        const act_controller::low_latency_report rep = ctrl.get_low_latency_report();
+        std::cout << "[rtt-bench] mode=" << (low_latency ? "low_latency" : "default")
+                  << " n=" << us.size() << " failed=" << failed
+                  << " p50_us=" << us[us.size() / 2]
+                  << " p99_us=" << us[us.size() * 99 / 100]
+                  << " max_us=" << us.back();
+        if (low_latency)
+            std::cout << " async_low_latency=" << rep.async_low_latency
+                      << " vmin_vtime=" << rep.vmin_vtime
+                      << " latency_timer_ms=" << rep.latency_timer_was_ms << "->" << rep.latency_timer_ms;
+        std::cout << std::endl;
+        ctrl.disconnect();
+    }
+}
+
+// Cost of one capture record on the I/O thread: a 17-byte frame copied into the mapping.
+static void bench_capture() {
+    using clock = std::chrono::steady_clock;
+    const std::string path = "/tmp/act_controller_bench_capture";
+    act_controller::wire_capture cap;
+    const std::size_t n = 1000000;
+    if (!cap.open(path, n * 32 + 64, act_controller::k_default_baud)) {
+        std::cout << "[capture-bench] cannot map " << path << std::endl;
+        return;
+    }
+    uint8_t frame[17];
+    for (std::size_t i = 0; i < sizeof(frame); ++i) frame[i] = static_cast<uint8_t>(i);
+    const auto t0 = clock::now();
+    for (std::size_t i = 0; i < n; ++i)
+        cap.record(act_controller::wire_capture::kind::rx, act_controller::wire_capture::crc_state::ok,
+                   act_controller::wire_op::status, frame, sizeof(frame));
+    const double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count() / static_cast<double>(n);
+    const uint64_t dropped = cap.counters().dropped;
+    cap.close();
+    std::remove(path.c_str());
+    std::cout << "[capture-bench] records=" << n << " ns/record=" << std::fixed << std::setprecision(1) << ns
+              << std::defaultfloat << " dropped=" << dropped << std::endl;
+}
+
+// bench_act_controller [--quick] [--json PATH] [--label NAME] [--compare PATH] [device]
+int main(int argc, char** argv) {
+    std::string json, label, compare, device;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--quick") g_budget_scale = 0.2;
+        else if (a == "--json" && i + 1 < argc) json = argv[++i];
+        else if (a == "--label" && i + 1 < argc) label = argv[++i];
+        else if (a == "--compare" && i + 1 < argc) compare = argv[++i];
+        else device = a;
+    }
+    bench_crc16();
+    bench_capture();
+    bench_hot_paths();
+    bench_cycles_sim();
+#ifndef _WIN32
+    bench_cycles_pty();
+#endif
+    bench_rtt(device);
+    if (!json.empty()) write_json(json, label);
+    if (!compare.empty()) compare_with(compare);
+    if (g_failed_cases > 0) std::cout << "[bench] " << g_failed_cases << " case(s) failed" << std::endl;
+    std::cout << "[all-bench-done]" << std::endl;
+    return g_failed_cases > 0 ? 1 : 0;
+}
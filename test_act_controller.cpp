@@ -6,9 +6,30 @@
 #include <cmath>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <new>
 
-#define ACT_CONTROLLER_NO_MAIN
-#include "act_controller.cpp"
+#define ACT_EMULATOR_NO_MAIN
+#include "act_emulator.cpp"
+
+// Global operator new replacement counting heap allocations while g_count_allocs is set,
+// on every thread (the controller's I/O thread included) except those marked exempt
+// (the fake controller's own thread).
+static std::atomic<bool> g_count_allocs{false};
+static std::atomic<long> g_allocs{0};
+static thread_local bool t_alloc_exempt = false;
+
+// Out of line, so GCC does not pair an inlined malloc/free with new/delete expressions
+[[gnu::noinline]] void* operator new(std::size_t n) {
+    if (g_count_allocs.load(std::memory_order_relaxed) && !t_alloc_exempt)
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
 
 // Local reimplementation of hex_to_bytes & crc16 for isolated utility tests (mirrors private logic)
 static std::vector<uint8_t> test_hex_to_bytes(const std::string& hex) {
@@ -43,6 +64,239 @@ static uint16_t test_crc16_modbus(const uint8_t* data, size_t len) {
     return crc;
 }
 
+
+#ifndef _WIN32
+#include <atomic>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+// Controller stand-in on a pseudo-terminal. Answers register reads with zeroed data
+// (position 0x9001 = position_raw, status word 0x9000 = the busy or in-position flags),
+// echoes coil writes and acks register writes. Reads shorter than min_read_qty get an
+// illegal-address exception, and so does the combined 0x0411..0x0413 write when
+// refuse_combined is set.
+// Absolute moves latch the 0x0412 target at the coil 0x001A ON pulse and arrive after
+// move_time + move_rate * distance / speed (external units, 0x0411 speed). A silent instance never answers, like a tty with nothing attached.
+class fake_pty_controller {
+public:
+    explicit fake_pty_controller(bool silent = false, int16_t position_raw = 1234)
+        : silent_(silent), position_raw_(position_raw) {
+        master_ = ::posix_openpt(O_RDWR | O_NOCTTY);
+        assert(master_ >= 0);
+        assert(::grantpt(master_) == 0 && ::unlockpt(master_) == 0);
+        slave_name_ = ::ptsname(master_);
+        // Keep one slave fd open so client open/close cycles never hang up the master
+        slave_keep_ = ::open(slave_name_.c_str(), O_RDWR | O_NOCTTY);
+        termios tio{};
+        ::tcgetattr(slave_keep_, &tio);
+        ::cfmakeraw(&tio);
+        ::tcsetattr(slave_keep_, TCSANOW, &tio);
+        th_ = std::thread([this] { loop(); });
+    }
+    ~fake_pty_controller() {
+        stop_ = true;
+        th_.join();
+        ::close(slave_keep_);
+        ::close(master_);
+    }
+    const std::string& port() const { return slave_name_; }
+    int frames_seen() const { return frames_; }
+    int frames_seen(uint8_t slave) const { return per_slave_[slave]; }
+    void set_position_raw(int16_t raw) { position_raw_ = raw; }
+    void set_move_time(std::chrono::milliseconds t) { move_time_ms_ = static_cast<int>(t.count()); }
+    void set_move_rate(int ms_per_unit) { move_rate_ms_ = ms_per_unit; }
+    void set_status_flags(uint16_t busy, uint16_t in_position) { busy_flag_ = busy; in_position_flag_ = in_position; }
+    // After a start pulse, the next `reads` status reads still show the previous move's
+    // position and in-position flag, as a drive that picks the pulse up a poll late
+    void set_flag_lag(int reads) { flag_lag_ = reads; }
+    void set_min_read_qty(int qty) { min_read_qty_ = qty; }
+    void set_refuse_combined(bool refuse) { refuse_combined_ = refuse; }
+    // Requests from index `from` on, as "func reg word" in hex (word: quantity, or coil value)
+    std::vector<std::string> requests(int from) const {
+        std::lock_guard<std::mutex> lk(log_mutex_);
+        return std::vector<std::string>(log_.begin() + std::min<std::size_t>(from, log_.size()), log_.end());
+    }
+    // Answer reads of this register with exception 0x02 (-1: none)
+    void set_refused_register(int reg) { refused_reg_ = reg; }
+    // Raw bytes written just before the next reply (noise, stray frames)
+    void inject_before_next_reply(std::vector<uint8_t> bytes) {
+        std::lock_guard<std::mutex> lk(inject_mutex_);
+        inject_ = std::move(bytes);
+    }
+    // Answer only while the line is set to this rate (0: any rate)
+    void set_baud(unsigned baud) { baud_ = baud; }
+    // A one-register 0x10 write to reg switches the fake to value * 100 baud once acked
+    void set_baud_register(uint16_t reg) { baud_reg_ = reg; }
+    // Swallow the next n replies, as if they were lost on the line
+    void drop_replies(int n) { drop_replies_ = n; }
+    // Answer n more requests, then none (-1: no limit)
+    void answer_only(int n) { answer_budget_ = n; }
+    int last_read_qty() const { return last_read_qty_; }
+
+private:
+    void reply(const std::vector<uint8_t>& body) {
+        if (drop_replies_ > 0) {
+            --drop_replies_;
+            return;
+        }
+        if (answer_budget_ == 0) return;
+        if (answer_budget_ > 0) --answer_budget_;
+        std::vector<uint8_t> f;
+        {
+            std::lock_guard<std::mutex> lk(inject_mutex_);
+            f.swap(inject_);
+        }
+        f.insert(f.end(), body.begin(), body.end());
+        uint16_t crc = test_crc16_modbus(f.data() + f.size() - body.size(), body.size());
+        f.push_back(static_cast<uint8_t>(crc & 0xFF));
+        f.push_back(static_cast<uint8_t>(crc >> 8));
+        (void)!::write(master_, f.data(), f.size());
+    }
+
+    // Rate the client configured on the tty (pty pairs keep termios even if they ignore it)
+    unsigned line_baud() const {
+        termios tio{};
+        if (::tcgetattr(slave_keep_, &tio) != 0) return 0;
+        switch (::cfgetospeed(&tio)) {
+        case B9600: return 9600;
+        case B19200: return 19200;
+        case B38400: return 38400;
+        case B57600: return 57600;
+        case B115200: return 115200;
+        case B230400: return 230400;
+        default: return 0;
+        }
+    }
+
+    void loop() {
+        t_alloc_exempt = true;
+        std::vector<uint8_t> buf;
+        while (!stop_) {
+            pollfd pfd{master_, POLLIN, 0};
+            if (::poll(&pfd, 1, 20) <= 0 || !(pfd.revents & POLLIN)) continue;
+            uint8_t tmp[256];
+            ssize_t n = ::read(master_, tmp, sizeof(tmp));
+            if (n <= 0) continue;
+            buf.insert(buf.end(), tmp, tmp + n);
+            while (buf.size() >= 8) {
+                const uint8_t func = buf[1];
+                std::size_t len = 8;
+                if (func == 0x10 || func == 0x0F) len = 9 + buf[6];
+                else if (func != 0x03 && func != 0x05) { buf.erase(buf.begin()); continue; }
+                if (buf.size() < len) break;
+                std::vector<uint8_t> req(buf.begin(), buf.begin() + len);
+                buf.erase(buf.begin(), buf.begin() + len);
+                {
+                    char entry[16];
+                    std::snprintf(entry, sizeof(entry), "%02X %02X%02X %02X%02X", func, req[2], req[3], req[4], req[5]);
+                    std::lock_guard<std::mutex> lk(log_mutex_);
+                    log_.emplace_back(entry);
+                }
+                ++frames_;
+                ++per_slave_[req[0]];
+                if (silent_) continue;
+                if (baud_ != 0 && line_baud() != baud_) continue; // garbage at the wrong rate
+                const uint16_t reg = static_cast<uint16_t>((req[2] << 8) | req[3]);
+                if (func == 0x10 && reg == baud_reg_ && len == 11) {
+                    reply(std::vector<uint8_t>(req.begin(), req.begin() + 6));
+                    baud_ = static_cast<unsigned>((req[7] << 8) | req[8]) * 100;
+                    continue;
+                }
+                if (func == 0x10 && reg == 0x0411 && len == 11) {
+                    pending_speed_ = std::max(1, (req[7] << 8) | req[8]);
+                } else if (func == 0x10 && reg == 0x0411 && len == 15) {
+                    if (refuse_combined_) {
+                        reply({req[0], 0x90, 0x02});
+                        continue;
+                    }
+                    pending_speed_ = std::max(1, (req[7] << 8) | req[8]);
+                    pending_raw_ = static_cast<int16_t>((req[11] << 8) | req[12]);
+                } else if (func == 0x10 && reg == 0x0412 && len == 13) {
+                    pending_raw_ = static_cast<int16_t>((req[9] << 8) | req[10]);
+                } else if (func == 0x05 && reg == 0x001A && req[4] == 0xFF) {
+                    target_raw_ = pending_raw_;
+                    const int distance = std::abs(target_raw_ - position_raw_.load()) / 100;
+                    const int ms = move_time_ms_.load() + move_rate_ms_.load() * distance / pending_speed_;
+                    arrive_at_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+                    moving_ = true;
+                    stale_reads_ = flag_lag_;
+                    stale_raw_ = position_raw_;
+                }
+                if (moving_ && std::chrono::steady_clock::now() >= arrive_at_) {
+                    position_raw_ = target_raw_;
+                    moving_ = false;
+                }
+                if (func == 0x03) {
+                    const uint16_t addr = static_cast<uint16_t>((req[2] << 8) | req[3]);
+                    const uint16_t qty = static_cast<uint16_t>((req[4] << 8) | req[5]);
+                    last_read_qty_ = qty;
+                    if (qty < min_read_qty_ || addr == refused_reg_) {
+                        reply({req[0], 0x83, 0x02});
+                        continue;
+                    }
+                    std::vector<uint8_t> body = {req[0], 0x03, static_cast<uint8_t>(2 * qty)};
+                    body.resize(3 + 2 * qty, 0);
+                    if (addr == 0x9000 && qty >= 2) {
+                        uint16_t st = moving_ ? busy_flag_.load() : in_position_flag_.load();
+                        int16_t raw_now = position_raw_;
+                        if (stale_reads_ > 0) {
+                            --stale_reads_;
+                            st = in_position_flag_;
+                            raw_now = stale_raw_;
+                        }
+                        body[3] = static_cast<uint8_t>(st >> 8);
+                        body[4] = static_cast<uint8_t>(st & 0xFF);
+                        const uint16_t raw = static_cast<uint16_t>(raw_now);
+                        body[5] = static_cast<uint8_t>(raw >> 8);
+                        body[6] = static_cast<uint8_t>(raw & 0xFF);
+                    }
+                    reply(body);
+                } else if (func == 0x05) {
+                    reply(std::vector<uint8_t>(req.begin(), req.begin() + 6));
+                } else {
+                    reply(std::vector<uint8_t>(req.begin(), req.begin() + 6));
+                }
+            }
+        }
+    }
+
+    bool silent_;
+    std::atomic<int16_t> position_raw_;
+    std::atomic<int> move_time_ms_{0};
+    std::atomic<int> move_rate_ms_{0};
+    std::atomic<uint16_t> busy_flag_{0};
+    std::atomic<uint16_t> in_position_flag_{0};
+    std::atomic<int> min_read_qty_{0};
+    std::atomic<bool> refuse_combined_{false};
+    std::atomic<int> refused_reg_{-1};
+    std::atomic<int> flag_lag_{0};
+    std::mutex inject_mutex_;
+    std::vector<uint8_t> inject_;
+    mutable std::mutex log_mutex_;
+    std::vector<std::string> log_;
+    std::atomic<int> last_read_qty_{0};
+    std::atomic<int> drop_replies_{0};
+    std::atomic<int> answer_budget_{-1};
+    std::atomic<unsigned> baud_{0};
+    std::atomic<int> baud_reg_{-1};
+    int16_t pending_raw_ = 0; // motion model, loop thread only
+    int pending_speed_ = 1;
+    int16_t target_raw_ = 0;
+    bool moving_ = false;
+    int stale_reads_ = 0;
+    int16_t stale_raw_ = 0;
+    std::chrono::steady_clock::time_point arrive_at_;
+    int master_ = -1;
+    int slave_keep_ = -1;
+    std::string slave_name_;
+    std::atomic<bool> stop_{false};
+    std::atomic<int> frames_{0};
+    std::atomic<int> per_slave_[256] = {};
+    std::thread th_;
+};
+#endif
+
 // Basic utility tests
 static void run_util_tests() {
     {
@@ -59,6 +313,1082 @@ static void run_util_tests() {
     std::cout << "[util-tests] ok" << std::endl;
 }
 
+// Compile-time frame builder: constant frames, runtime patching, CRC verification
+static void run_frame_builder_tests() {
+    constexpr auto probe = modbus::read_holding(0x01, 0x9000, 0x0010);
+    static_assert(probe[6] == 0x69 && probe[7] == 0x06, "probe CRC");
+    static_assert(modbus::crc16(probe.data(), probe.size()) == 0, "CRC over a sealed frame is zero");
+    {
+        auto expect = test_hex_to_bytes("01 03 90 00 00 10 69 06");
+        assert(std::equal(expect.begin(), expect.end(), probe.data()));
+        assert(test_crc16_modbus(probe.data(), 6) == probe.crc());
+    }
+    {
+        // Absolute position frame with a runtime position patched in (50 -> 0x1388)
+        auto f = modbus::write_registers(0x01, 0x0412, std::array<uint16_t, 2>{0x0000, 0x0000});
+        f.set_u16(modbus::write_register_offset(1), 5000);
+        auto expect = test_hex_to_bytes("01 10 04 12 00 02 04 00 00 13 88");
+        assert(f.size() == expect.size() + 2);
+        assert(std::equal(expect.begin(), expect.end(), f.data()));
+        assert(f.crc() == test_crc16_modbus(expect.data(), expect.size()));
+        assert(f.crc_ok());
+    }
+    {
+        // The controller's own builders (speed 10, position 50 / delta -3)
+        const auto abs = act_controller::absolute_params_frame(50, 10);
+        const auto expect = test_hex_to_bytes("01 10 04 11 00 03 06 00 0a 00 00 13 88");
+        assert(abs.size() == expect.size() + 2 && abs.crc_ok());
+        assert(std::equal(expect.begin(), expect.end(), abs.data()));
+        const auto rel = act_controller::relative_move_frame(-3, 10);
+        assert(rel.crc_ok() && rel[9] == 0x00 && rel[10] == 0x0a && rel[11] == 0xff && rel[12] == 0xff);
+    }
+    {
+        const uint8_t good[] = {0x01, 0x05, 0x00, 0x1a, 0x00, 0x00, 0xec, 0x0d};
+        const uint8_t bad[]  = {0x01, 0x05, 0x00, 0x1a, 0x00, 0x00, 0xec, 0x0e};
+        assert(modbus::checked(good) == modbus::write_coil(0x01, 0x001A, false));
+        bool threw = false;
+        try { (void)modbus::checked(bad); } catch (const std::logic_error&) { threw = true; }
+        assert(threw);
+    }
+    std::cout << "[frame-builder-tests] ok" << std::endl;
+}
+
+// Replies arriving in arbitrary chunks, behind noise or with corrupted frames in between
+static void run_rtu_parser_tests() {
+    // t3.5 between frames: 3.5 11-bit characters up to 19200 baud, 1.75 ms above
+    using std::chrono::microseconds;
+    assert(act_controller::inter_frame_gap(9600) == microseconds(4010));
+    assert(act_controller::inter_frame_gap(19200) == microseconds(2005));
+    assert(act_controller::inter_frame_gap(38400) == microseconds(1750));
+    assert(act_controller::inter_frame_gap(115200) == microseconds(1750));
+
+    auto sealed = [](std::vector<uint8_t> f) {
+        const uint16_t crc = test_crc16_modbus(f.data(), f.size());
+        f.push_back(static_cast<uint8_t>(crc & 0xFF));
+        f.push_back(static_cast<uint8_t>(crc >> 8));
+        return f;
+    };
+    const auto ack = sealed(test_hex_to_bytes("01 05 00 1a ff 00"));
+    const auto read = sealed(test_hex_to_bytes("01 03 04 00 02 09 c4"));
+    const auto exc = sealed(test_hex_to_bytes("01 83 02"));
+    auto bad = read;
+    bad[4] ^= 0x10;
+
+    // Noise, an ack, a corrupted read, a good read and an exception, one byte at a time
+    std::vector<uint8_t> stream = {0x00, 0xff, 0x13};
+    for (const std::vector<uint8_t>* f : {&ack, static_cast<const std::vector<uint8_t>*>(&bad), &read, &exc})
+        stream.insert(stream.end(), f->begin(), f->end());
+    for (std::size_t chunk : {std::size_t(1), std::size_t(3), std::size_t(7), stream.size()}) {
+        modbus::rtu_parser parser;
+        std::vector<std::vector<uint8_t>> got;
+        for (std::size_t i = 0; i < stream.size(); i += chunk) {
+            parser.feed(stream.data() + i, std::min(chunk, stream.size() - i));
+            const uint8_t* f = nullptr;
+            while (std::size_t n = parser.next(&f)) got.emplace_back(f, f + n);
+        }
+        assert(got.size() == 3 && got[0] == ack && got[1] == read && got[2] == exc);
+        const modbus::rtu_parser::stats& c = parser.counters();
+        assert(c.frames == 3 && c.exceptions == 1 && c.crc_errors >= 1);
+        assert(c.discarded == 3 + bad.size() && c.resyncs == 2 && parser.pending() == 0);
+    }
+
+    // A noise byte that looks like the start of a long read must not hide a whole ack behind it
+    {
+        modbus::rtu_parser parser;
+        const uint8_t noise[] = {0x01, 0x03, 0x40};
+        parser.feed(noise, sizeof noise);
+        parser.feed(ack.data(), ack.size());
+        const uint8_t* f = nullptr;
+        const std::size_t n = parser.next(&f);
+        assert(n == ack.size() && std::equal(ack.begin(), ack.end(), f));
+        assert(parser.counters().discarded == 3 && parser.pending() == 0);
+    }
+
+    // A partial frame stays pending until dropped
+    {
+        modbus::rtu_parser parser;
+        parser.feed(read.data(), 5);
+        const uint8_t* f = nullptr;
+        assert(parser.next(&f) == 0 && parser.pending() == 5);
+        parser.discard_pending();
+        parser.feed(exc.data(), exc.size());
+        assert(parser.next(&f) == exc.size() && parser.counters().discarded == 5);
+    }
+    std::cout << "[rtu-parser-tests] ok" << std::endl;
+}
+
+// Every CRC engine must match the bit-at-a-time reference, for any length and alignment
+static void run_crc_engine_tests() {
+    std::vector<uint8_t> buf(5000 + 8);
+    uint32_t seed = 0x12345678u;
+    for (auto& b : buf) { seed = seed * 1103515245u + 12345u; b = static_cast<uint8_t>(seed >> 16); }
+    const modbus::crc16_engine engines[] = {
+        modbus::crc16_engine::table, modbus::crc16_engine::slice8, modbus::crc16_engine::clmul};
+    for (std::size_t len : {0, 1, 2, 7, 8, 9, 16, 41, 63, 64, 65, 127, 128, 200, 1000, 4999, 5000}) {
+        for (std::size_t off = 0; off < 8; ++off) {
+            const uint16_t ref = test_crc16_modbus(buf.data() + off, len);
+            for (auto e : engines) assert(modbus::crc16_with(e, buf.data() + off, len) == ref);
+            assert(modbus::crc16_fast(buf.data() + off, len) == ref);
+        }
+    }
+    // Chained (streaming) use must equal one pass
+    const uint16_t split = modbus::crc16_fast(buf.data() + 300, 700, modbus::crc16_fast(buf.data(), 300));
+    assert(split == test_crc16_modbus(buf.data(), 1000));
+    std::cout << "[crc-engine-tests] ok best=" << modbus::crc16_engine_name(modbus::crc16_best_engine()) << std::endl;
+}
+
+// Last-known-good ranking: the adapter serial follows a re-plugged arm to a new ttyUSBn
+static void run_port_ranking_tests() {
+    using pi = act_controller::port_info;
+    std::vector<pi> ports(4);
+    ports[0].device = "/dev/ttyS0";
+    ports[1].device = "/dev/ttyUSB0"; ports[1].vid = 0x0403; ports[1].pid = 0x6001; ports[1].serial = "OTHER";
+    ports[2].device = "/dev/ttyUSB1"; ports[2].vid = 0x0403; ports[2].pid = 0x6001; ports[2].serial = "ARM42";
+    ports[3].device = "/dev/ttyACM0"; ports[3].vid = 0x2341; ports[3].pid = 0x0043;
+
+    act_controller::port_fingerprint last;
+    last.device = "/dev/ttyUSB0"; // the arm used to be ttyUSB0 ...
+    last.adapter_serial = "ARM42"; // ... but its adapter now enumerates as ttyUSB1
+    last.vid = 0x0403; last.pid = 0x6001;
+    act_controller::rank_ports(ports, last);
+    assert(ports[0].device == "/dev/ttyUSB1");
+    assert(ports[1].device == "/dev/ttyUSB0");
+    assert(ports.back().device == "/dev/ttyS0");
+
+    // No history: USB adapters first, enumeration order otherwise kept
+    act_controller::rank_ports(ports, act_controller::port_fingerprint{});
+    assert(ports.back().device == "/dev/ttyS0");
+
+    const std::string path = "/tmp/act_controller_test_fp";
+    assert(act_controller::save_port_fingerprint(path, last));
+    auto back = act_controller::load_port_fingerprint(path);
+    assert(back.device == last.device && back.adapter_serial == last.adapter_serial);
+    assert(back.vid == 0x0403 && back.pid == 0x6001);
+    std::remove(path.c_str());
+    std::cout << "[port-ranking-tests] ok enumerated=" << act_controller::enumerate_ports().size() << std::endl;
+}
+
+#ifndef _WIN32
+// Concurrent discovery: silent and missing ports cost one deadline, not one each
+static void run_discovery_tests() {
+    using namespace std::chrono;
+    fake_pty_controller live;
+    fake_pty_controller silent1(true), silent2(true);
+    const std::vector<std::string> candidates = {
+        "/dev/act-test-missing", silent1.port(), silent2.port(), live.port()};
+
+    auto t0 = steady_clock::now();
+    auto all = act_controller::discover(candidates, milliseconds(150));
+    auto dt = duration_cast<milliseconds>(steady_clock::now() - t0).count();
+    assert(all.size() == 1 && all[0].port == live.port());
+    assert(dt < 400); // bounded by one probe timeout, not three
+
+    t0 = steady_clock::now();
+    auto first = act_controller::discover(candidates, milliseconds(1000), true);
+    dt = duration_cast<milliseconds>(steady_clock::now() - t0).count();
+    assert(first.size() == 1 && first[0].port == live.port());
+    assert(dt < 500); // first hit ends the scan before the silent ports time out
+    std::cout << "[discovery-tests] ok latency_us=" << first[0].latency.count() << std::endl;
+}
+
+// Full connect + position read against the pty stand-in
+static void run_fake_connect_test() {
+    fake_pty_controller live(false, -1234);
+    const std::string cache = "/tmp/act_controller_test_last_port";
+    std::remove(cache.c_str());
+    act_controller ctrl;
+    ctrl.init();
+    ctrl.set_port_cache_path(cache);
+    int rc = ctrl.connect(live.port());
+    assert(rc == 0 && ctrl.is_connected());
+    assert(ctrl.last_init_report().ok);
+    assert(ctrl.get_current_position() == -12);
+    ctrl.disconnect();
+    assert(!ctrl.is_connected());
+    // Successful connect records the last-known-good port
+    auto fp = act_controller::load_port_fingerprint(cache);
+    assert(fp.device == live.port());
+    std::remove(cache.c_str());
+    std::cout << "[fake-connect-test] ok init_us=" << ctrl.last_init_report().elapsed.count() << std::endl;
+}
+
+// Init steps are answered in wire time; an unacknowledged one is reported, and only
+// strict init refuses the connection
+static void run_init_sequence_test() {
+    using namespace std::chrono;
+    fake_pty_controller live(false, 2500);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    assert(!ctrl.get_strict_init());
+    assert(ctrl.connect(live.port()) == 0);
+    act_controller::init_report rep = ctrl.last_init_report();
+    assert(rep.ok && rep.failed_step == -1 && rep.unacked == 0);
+    assert(rep.elapsed < milliseconds(500)); // 20 round trips, not 20 x 100 ms sleeps
+    const auto acked_us = rep.elapsed.count();
+    ctrl.disconnect();
+
+    // Step 5 (read of 0x0150) refused: lenient init sends all 20 frames and connects
+    live.set_refused_register(0x0150);
+    int frames0 = live.frames_seen();
+    assert(ctrl.connect(live.port()) == 0 && ctrl.is_connected());
+    rep = ctrl.last_init_report();
+    assert(!rep.ok && rep.failed_step == 5 && rep.unacked == 1);
+    assert(rep.status == act_controller::reply_status::exception && rep.exception_code == 0x02);
+    assert(live.frames_seen() - frames0 == 1 + 20); // probe + every init step
+    assert(ctrl.get_current_position() == 25);
+    ctrl.disconnect();
+
+    // Strict init stops there and refuses the connection
+    ctrl.set_strict_init(true);
+    frames0 = live.frames_seen();
+    assert(ctrl.connect(live.port()) != 0 && !ctrl.is_connected());
+    rep = ctrl.last_init_report();
+    assert(!rep.ok && rep.failed_step == 5 && rep.unacked == 1);
+    assert(live.frames_seen() - frames0 == 1 + 6);
+    std::cout << "[init-sequence-test] ok init_us=" << acked_us << std::endl;
+}
+
+// Telemetry: one poller publishes, readers see consistent samples with no bus traffic
+static void run_telemetry_test() {
+    using namespace std::chrono;
+    fake_pty_controller live(false, 500);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    assert(ctrl.connect(live.port()) == 0);
+    assert(ctrl.latest_sample().sequence == 0);
+    // A relative move holds the queue for its frame pause, so the first poll waits: until
+    // it lands, the position comes from the bus, not a zero sample
+    ctrl.async_move_relative(1, 10, [](const asio::error_code&) {});
+    assert(ctrl.start_telemetry(milliseconds(5)));
+    assert(!ctrl.start_telemetry()); // already running
+    assert(ctrl.latest_sample().sequence == 0 && ctrl.get_current_position() == 5);
+
+    // Readers never see a half-written sample while the position keeps changing
+    std::atomic<bool> stop{false};
+    std::atomic<long> reads{0};
+    std::thread reader([&] {
+        while (!stop) {
+            auto smp = ctrl.latest_sample();
+            if (smp.sequence == 0) continue;
+            int expect = smp.raw >= 0 ? (smp.raw + 50) / 100 : (smp.raw - 50) / 100;
+            assert(smp.position == expect);
+            ++reads;
+        }
+    });
+    for (int16_t raw = 500; raw < 1500; raw += 50) {
+        live.set_position_raw(raw);
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    stop = true;
+    reader.join();
+
+    const auto before = ctrl.latest_sample();
+    assert(before.sequence > 10 && before.raw == 1450);
+    // get_current_position() is served from the sample: frames on the wire come only
+    // from the poller, not from the 1000 calls below
+    const int frames0 = live.frames_seen();
+    for (int i = 0; i < 1000; ++i) assert(ctrl.get_current_position() == 15);
+    assert(live.frames_seen() - frames0 < 50);
+
+    // Polls stuck behind a move: the sample goes stale and reads go to the bus again
+    ctrl.async_move_relative(1, 10, [](const asio::error_code&) {});
+    std::this_thread::sleep_for(milliseconds(30));
+    live.set_position_raw(900);
+    assert(ctrl.read_status().position == 9 && ctrl.get_current_position() == 9);
+    ctrl.stop_telemetry();
+    assert(!ctrl.telemetry_running());
+    ctrl.disconnect();
+    std::cout << "[telemetry-test] ok samples=" << before.sequence << " reads=" << reads.load() << std::endl;
+}
+
+// Async API: callbacks and futures on the same I/O thread, jobs run in submission order
+static void run_async_api_test() {
+    fake_pty_controller live(false, 700);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    // Not connected: the future carries the error instead of blocking
+    auto idle = ctrl.async_get_position(asio::use_future);
+    try {
+        idle.get();
+        assert(false);
+    } catch (const asio::system_error& e) {
+        assert(e.code() == asio::error::not_connected);
+    }
+
+    assert(ctrl.connect(live.port()) == 0);
+    const int frames0 = live.frames_seen();
+    int order = 0, move_done = -1;
+    asio::error_code move_ec = asio::error::timed_out;
+    ctrl.async_move_relative(3, 10, [&](const asio::error_code& ec) {
+        move_ec = ec;
+        move_done = order++;
+    });
+    auto pos = ctrl.async_get_position(asio::use_future);
+    assert(pos.get() == 7);
+    assert(move_done == 0 && !move_ec); // queued first, finished first
+    auto abs = ctrl.async_move_absolute(4, 10, asio::use_future);
+    abs.get();
+    // relative (+): block + trigger; position read; legacy absolute: speed, position,
+    // coil OFF, multi-coil, coil ON/OFF
+    assert(live.frames_seen() - frames0 == 9);
+    ctrl.disconnect();
+    std::cout << "[async-api-test] ok" << std::endl;
+}
+
+// Trajectory: acked frames, look-ahead preload, per-segment results
+static void run_trajectory_test() {
+    using namespace std::chrono;
+    fake_pty_controller live(false, 0);
+    live.set_move_time(milliseconds(40));
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    assert(ctrl.connect(live.port()) == 0);
+    const std::vector<act_controller::waypoint> path = {
+        {10, 10, milliseconds(0)}, {20, 10, milliseconds(15)}, {5, 10, milliseconds(0)}};
+
+    // Default: each segment is loaded once the previous one has arrived
+    auto res = ctrl.run_trajectory(path);
+    assert(res.size() == 3);
+    for (std::size_t i = 0; i < res.size(); ++i)
+        assert(res[i].arrived && !res[i].preloaded && res[i].reached == path[i].position);
+
+    // Look-ahead: the next segment's parameters go out during the current move
+    act_controller::trajectory_options ahead;
+    ahead.lookahead = true;
+    const auto t0 = steady_clock::now();
+    res = ctrl.run_trajectory(path, ahead);
+    const auto took = duration_cast<milliseconds>(steady_clock::now() - t0);
+    assert(res.size() == 3);
+    for (std::size_t i = 0; i < res.size(); ++i) {
+        assert(res[i].arrived && !res[i].error);
+        assert(res[i].commanded == path[i].position && res[i].reached == path[i].position);
+        assert(res[i].in_position >= res[i].triggered + milliseconds(30));
+        assert(res[i].preloaded == (i > 0));
+        if (i > 0) assert(res[i].triggered >= res[i - 1].in_position);
+    }
+    // Three 40 ms moves: no 100 ms sleeps or 300 ms ack windows in between
+    assert(took < milliseconds(400));
+
+    // A target that is never reached ends the run with timed_out on that segment
+    act_controller::trajectory_options opt;
+    opt.segment_timeout = milliseconds(100);
+    live.set_move_time(seconds(10));
+    res = ctrl.run_trajectory({{30, 10, milliseconds(0)}, {40, 10, milliseconds(0)}}, opt);
+    assert(res.size() == 1 && !res[0].arrived && res[0].error == asio::error::timed_out);
+    ctrl.disconnect();
+    std::cout << "[trajectory-test] ok ms=" << took.count() << std::endl;
+}
+
+// Settle estimator: the least-squares fit, then blocking moves waking near arrival
+static void run_settle_estimator_test() {
+    using namespace std::chrono;
+    // Fit: 100 ms + 20 ms per (unit / speed), exact points
+    act_controller::motion_estimator est;
+    assert(!est.predict(10, 1));
+    est.observe(10, 1, milliseconds(300));
+    est.observe(20, 2, milliseconds(300));
+    assert(est.calibrated() && est.slope_ms() == 0.0); // one distinct x: constant model
+    assert(std::abs(est.overhead_ms() - 300.0) < 0.5);
+    est.reset();
+    est.observe(10, 1, milliseconds(300));
+    est.observe(40, 2, milliseconds(500));
+    est.observe(-5, 1, milliseconds(200));
+    assert(est.calibrated() && est.samples() == 3);
+    assert(std::abs(est.overhead_ms() - 100.0) < 0.5 && std::abs(est.slope_ms() - 20.0) < 0.01);
+    assert(std::abs(duration_cast<milliseconds>(*est.predict(30, 1)).count() - 700) <= 1);
+    assert(est.margin() == act_controller::k_dense_poll);
+    est.note_late();
+    assert(est.margin() == 2 * act_controller::k_dense_poll);
+
+    // Calibrate from two blind-polled moves, then the third wakes near its arrival
+    fake_pty_controller live(false, 0);
+    live.set_move_time(milliseconds(550));
+    live.set_move_rate(10);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    assert(ctrl.connect(live.port()) == 0);
+    // Nothing known about the start yet, and no bus read to find out: not predicted
+    assert(ctrl.move_absolute_blocking(0, 2, 5) == 0);
+    act_controller::settle_report r = ctrl.last_settle_report();
+    assert(r.arrived && r.distance == -1 && ctrl.estimator().samples() == 0);
+    // From then on each move starts where the previous one arrived
+    assert(ctrl.move_absolute_blocking(20, 2, 5) == 0);
+    r = ctrl.last_settle_report();
+    assert(r.arrived && !r.calibrated && r.distance == 20 && r.polls >= 2);
+    assert(ctrl.move_absolute_blocking(60, 1, 5) == 0);
+    assert(ctrl.estimator().samples() == 2 && ctrl.estimator().calibrated());
+    assert(ctrl.move_absolute_blocking(35, 1, 5) == 0);
+    r = ctrl.last_settle_report();
+    const auto err = duration_cast<milliseconds>(r.actual - r.predicted);
+    assert(r.arrived && r.calibrated && r.distance == 25);
+    assert(std::abs(err.count()) < 150 && r.polls <= 6);
+    ctrl.disconnect();
+    std::cout << "[settle-test] ok predicted_ms=" << duration_cast<milliseconds>(r.predicted).count()
+              << " actual_ms=" << duration_cast<milliseconds>(r.actual).count() << " polls=" << r.polls << std::endl;
+}
+
+static void run_status_read_test() {
+    using namespace std::chrono;
+    fake_pty_controller live(false, 2500);
+    live.set_status_flags(0x0001, 0x0002);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    assert(ctrl.connect(live.port()) == 0);
+
+    // Short read: two registers, decoded with the configured bits
+    act_controller::status_snapshot st = ctrl.read_status();
+    assert(live.last_read_qty() == 2);
+    assert(st.position == 25 && st.raw == 2500 && st.status == 0x0002 && !st.flags_known && !st.in_position);
+    ctrl.set_status_bits({0x0001, 0x0002, 0x0004});
+    st = ctrl.read_status();
+    assert(st.flags_known && st.in_position && !st.busy && !st.alarm);
+    assert(ctrl.get_current_position() == 25 && live.last_read_qty() == 2);
+
+    // Full block on request
+    const act_controller::status_block blk = ctrl.read_status_block();
+    assert(live.last_read_qty() == 16);
+    assert(blk.word(0x9000) == 0x0002 && blk.word(0x9001) == 2500 && blk.status.position == 25);
+
+    // The blocking move ends on the in-position flag: with a 100-unit tolerance the
+    // position check would already pass on the first read, still at 25 and busy
+    live.set_move_time(milliseconds(800));
+    assert(ctrl.move_absolute_blocking(40, 5, 3, 100) == 0);
+    act_controller::settle_report r = ctrl.last_settle_report();
+    assert(r.arrived && r.by_flag && r.polls >= 2 && ctrl.read_status().position == 40);
+
+    // The first read after the start pulse still shows the old position, in position and
+    // idle: the wait goes on until the move has been seen running, then arrives
+    live.set_flag_lag(1);
+    assert(ctrl.move_absolute_blocking(60, 5, 3, 100) == 0);
+    r = ctrl.last_settle_report();
+    assert(r.arrived && r.by_flag && r.polls >= 3 && ctrl.read_status().position == 60);
+    // Same when the tolerance already covers the old position
+    assert(ctrl.move_absolute_blocking(59, 5, 3, 2) == 0);
+    assert(ctrl.last_settle_report().polls >= 3 && ctrl.read_status().position == 59);
+    live.set_flag_lag(0);
+
+    // A controller refusing the short read gets the 16-register block from then on
+    live.set_min_read_qty(16);
+    st = ctrl.read_status();
+    assert(st.position == 59 && live.last_read_qty() == 16);
+    assert(ctrl.get_current_position() == 59 && live.last_read_qty() == 16);
+    ctrl.disconnect();
+    std::cout << "[status-read-test] ok" << std::endl;
+}
+
+static void run_framing_test() {
+    fake_pty_controller live(false, 2500);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    assert(ctrl.connect(live.port()) == 0);
+    const act_controller::serial_bus::rx_stats before = ctrl.framing_stats();
+
+    // Line noise ahead of the reply is skipped
+    live.inject_before_next_reply({0x00, 0xff, 0x01, 0x03, 0x40});
+    assert(ctrl.get_current_position() == 25);
+    act_controller::serial_bus::rx_stats after = ctrl.framing_stats();
+    assert(after.parser.discarded >= before.parser.discarded + 5);
+    assert(after.parser.resyncs > before.parser.resyncs);
+
+    // A well-formed frame that answers another request is not taken for the reply
+    const uint8_t stray[] = {0x01, 0x05, 0x00, 0x1a, 0xff, 0x00};
+    std::vector<uint8_t> f(stray, stray + sizeof stray);
+    const uint16_t crc = test_crc16_modbus(f.data(), f.size());
+    f.push_back(static_cast<uint8_t>(crc & 0xFF));
+    f.push_back(static_cast<uint8_t>(crc >> 8));
+    live.inject_before_next_reply(f);
+    assert(ctrl.get_current_position() == 25);
+    const act_controller::serial_bus::rx_stats last = ctrl.framing_stats();
+    assert(last.unmatched == after.unmatched + 1);
+    ctrl.disconnect();
+    std::cout << "[framing-test] ok" << std::endl;
+}
+
+static void run_transaction_test() {
+    using namespace std::chrono;
+    fake_pty_controller live(false, 2500);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    assert(ctrl.connect(live.port()) == 0);
+    for (int i = 0; i < 20; ++i) assert(ctrl.get_current_position() == 25);
+
+    // The first attempt's deadline now follows the measured turnaround
+    const act_controller::transaction_policy policy = ctrl.get_transaction_policy();
+    act_controller::transaction_stats st = ctrl.get_transaction_stats();
+    assert(st.samples >= 20 && st.p50 <= st.p99 && st.p99 <= st.max);
+    assert(st.allowance >= policy.min_turnaround && st.allowance < policy.max_turnaround);
+
+    // A lost reply costs one short wait and a retry
+    live.drop_replies(1);
+    auto t0 = steady_clock::now();
+    assert(ctrl.get_current_position() == 25);
+    const auto retried = steady_clock::now() - t0;
+    act_controller::transaction_stats after = ctrl.get_transaction_stats();
+    assert(after.retries == st.retries + 1 && after.timeouts == st.timeouts + 1);
+    assert(retried < policy.max_turnaround);
+
+    // Lost twice with one retry allowed: a bounded failure, not a hang
+    live.drop_replies(2);
+    t0 = steady_clock::now();
+    const act_controller::status_snapshot failed = ctrl.read_status();
+    const auto gave_up = steady_clock::now() - t0;
+    assert(failed.timestamp == steady_clock::time_point());
+    assert(gave_up >= policy.max_turnaround && gave_up < 2 * policy.max_turnaround);
+
+    // No retries: the first loss is the answer
+    act_controller::transaction_policy strict = policy;
+    strict.retries = 0;
+    ctrl.set_transaction_policy(strict);
+    live.drop_replies(1);
+    assert(ctrl.read_status().timestamp == steady_clock::time_point());
+    assert(ctrl.read_status().position == 25);
+    bool threw = false;
+    strict.max_turnaround = milliseconds(1);
+    try { ctrl.set_transaction_policy(strict); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    ctrl.disconnect();
+
+    // A pty answers at once, so inject a known turnaround with the emulator: the allowance
+    // follows rtt_factor x p99 up, then back down once the delayed samples leave the window
+    pty_emulator emu;
+    act_controller arm;
+    arm.set_port_cache_path("");
+    assert(arm.connect(emu.port()) == 0);
+    const microseconds latency(5000);
+    const int window = 128; // turnaround samples kept per arm
+    act_controller::simulated_actuator::params p = emu.drive().get_params();
+    p.reply_latency = latency;
+    emu.drive().set_params(p);
+    for (int i = 0; i < window; ++i) assert(arm.get_current_position() == 0);
+    const act_controller::transaction_stats slow = arm.get_transaction_stats();
+    auto tracks = [&](const act_controller::transaction_stats& s) {
+        const microseconds scaled(std::llround(policy.rtt_factor * static_cast<double>(s.p99.count())));
+        return s.allowance == std::clamp<microseconds>(scaled, policy.min_turnaround, policy.max_turnaround);
+    };
+    assert(slow.p99 >= latency && tracks(slow));
+    assert(slow.allowance >= microseconds(std::llround(policy.rtt_factor * static_cast<double>(latency.count()))));
+    p.reply_latency = microseconds(0);
+    emu.drive().set_params(p);
+    for (int i = 0; i < window; ++i) assert(arm.get_current_position() == 0);
+    const act_controller::transaction_stats quick = arm.get_transaction_stats();
+    assert(tracks(quick) && quick.allowance < slow.allowance);
+    arm.disconnect();
+    std::cout << "[transaction-test] ok p99_us=" << st.p99.count()
+              << " allowance_us=" << st.allowance.count()
+              << " retry_ms=" << duration_cast<milliseconds>(retried).count()
+              << " injected_p99_us=" << slow.p99.count() << " injected_allowance_us=" << slow.allowance.count()
+              << " recovered_allowance_us=" << quick.allowance.count() << std::endl;
+}
+
+static void run_baud_test() {
+    fake_pty_controller live(false, 2500);
+    live.set_baud(115200);
+    live.set_baud_register(0x0100);
+    {
+        // Nothing at the configured rate: auto-detection is off by default, so give up
+        act_controller fixed;
+        fixed.set_port_cache_path("");
+        assert(!fixed.get_line_settings().auto_detect);
+        assert(fixed.connect(live.port()) != 0);
+    }
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    act_controller::line_settings line;
+    line.auto_detect = true;
+    ctrl.set_line_settings(line);
+    assert(ctrl.connect(live.port()) == 0);
+    assert(ctrl.get_baud_rate() == 115200 && ctrl.get_line_settings().baud == 115200);
+    assert(ctrl.get_current_position() == 25);
+
+    // Switch the drive to 57600 and follow it
+    assert(ctrl.change_baud(57600, 0x0100, 576) == 0);
+    assert(ctrl.get_baud_rate() == 57600 && ctrl.get_current_position() == 25);
+
+    // A write the drive acks without switching: the port goes back to the working rate
+    assert(ctrl.change_baud(230400, 0x0101, 2304) == 1);
+    assert(ctrl.get_baud_rate() == 57600 && ctrl.get_current_position() == 25);
+    ctrl.disconnect();
+
+    // Found by rate detection, then silent: the re-probe fails, so connect() fails too
+    // (lenient init alone would pass a drive that answers nothing)
+    fake_pty_controller flaky(false, 2500);
+    flaky.set_baud(115200);
+    flaky.answer_only(1); // the discovery probe
+    act_controller lost;
+    lost.set_port_cache_path("");
+    lost.set_line_settings(line);
+    assert(lost.connect(flaky.port()) != 0 && !lost.is_connected());
+    std::cout << "[baud-test] ok" << std::endl;
+}
+
+// A pty has no serial driver or USB adapter: only the termios knob applies
+static void run_low_latency_test() {
+    fake_pty_controller live(false, 2500);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    act_controller::line_settings line;
+    line.low_latency = true;
+    ctrl.set_line_settings(line);
+    assert(ctrl.connect(live.port()) == 0);
+    const act_controller::low_latency_report rep = ctrl.get_low_latency_report();
+    assert(rep.requested && rep.vmin_vtime && !rep.async_low_latency);
+    assert(rep.latency_timer_ms == -1 && rep.latency_timer_was_ms == -1);
+    assert(ctrl.get_current_position() == 25);
+    ctrl.disconnect();
+    std::cout << "[low-latency-test] ok" << std::endl;
+}
+
+static void run_realtime_test() {
+    using namespace std::chrono;
+    fake_pty_controller live(false, 2500);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    assert(ctrl.connect(live.port()) == 0);
+
+    // SCHED_FIFO needs privileges this run may not have; affinity and slack do not.
+    // Pin to a CPU this process may use: CI runners are often cpuset-restricted.
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    assert(::sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    int cpu = 0;
+    while (cpu < CPU_SETSIZE - 1 && !CPU_ISSET(cpu, &allowed)) ++cpu;
+    act_controller::realtime_options opt;
+    opt.priority = 1;
+    opt.cpus = {cpu};
+    opt.lock_memory = false;
+    const act_controller::realtime_report rep = ctrl.enable_realtime(opt);
+    assert(rep.affinity && rep.timer_slack);
+    assert(rep.sched_fifo || rep.sched_errno == EPERM);
+
+    ctrl.reset_jitter();
+    assert(ctrl.start_telemetry(milliseconds(10)));
+    ctrl.move_relative(2, 10); // legacy pacing: frame gaps are timed wake-ups
+    std::this_thread::sleep_for(milliseconds(150));
+    ctrl.stop_telemetry();
+    const act_controller::jitter_recorder::snapshot polls = ctrl.jitter(act_controller::wake_kind::poll);
+    const act_controller::jitter_recorder::snapshot cmds = ctrl.jitter(act_controller::wake_kind::command);
+    assert(polls.samples >= 5 && cmds.samples >= 1);
+    assert(polls.mean <= polls.max && polls.p99 <= polls.max);
+    uint64_t total = 0;
+    for (uint64_t b : polls.buckets) total += b;
+    assert(total == polls.samples);
+    ctrl.disconnect();
+    std::cout << "[realtime-test] ok fifo=" << rep.sched_fifo << " cpu=" << cpu << " poll_p99_us=" << polls.p99.count()
+              << " cmd_max_us=" << cmds.max.count() << std::endl;
+}
+
+// The whole controller against the in-process simulator: no pty, no threads but the I/O one
+static void run_simulator_test() {
+    using namespace std::chrono;
+    act_controller::simulated_actuator::params sp;
+    sp.units_per_second = 1000.0;
+    auto sim = std::make_shared<act_controller::simulated_actuator>(sp);
+    act_controller ctrl(act_controller::simulated(sim));
+    ctrl.set_status_bits({0x0001, 0x0002, 0x0004});
+    assert(ctrl.connect("sim") == 0 && ctrl.get_port_name() == "sim");
+    assert(ctrl.get_current_position() == 0);
+
+    assert(ctrl.move_relative_blocking(5, 10, 2, 0) == 0 && sim->position() == 5);
+    assert(ctrl.move_relative_blocking(-3, 10, 2, 0) == 0 && ctrl.get_current_position() == 2);
+    assert(ctrl.move_absolute_blocking(40, 20, 2, 0) == 0 && sim->position() == 40);
+    ctrl.set_absolute_mode(act_controller::absolute_mode::fast);
+    assert(ctrl.move_absolute_blocking(10, 20, 2, 0) == 0 && sim->position() == 10);
+    ctrl.set_absolute_mode(act_controller::absolute_mode::legacy);
+    ctrl.reset();
+    assert(ctrl.get_current_position() == 10);
+
+    // The status read mid-move reports busy and an intermediate position
+    sp.units_per_second = 100.0;
+    sim->set_params(sp);
+    bool done = false;
+    ctrl.async_move_absolute(30, 10, [&](const asio::error_code& ec) { done = !ec; });
+    std::this_thread::sleep_for(milliseconds(100));
+    const act_controller::status_snapshot mid = ctrl.read_status();
+    assert(done && mid.busy && mid.position > 10 && mid.position < 30);
+    while (sim->moving()) std::this_thread::sleep_for(milliseconds(5));
+    assert(sim->position() == 30);
+    sp.units_per_second = 1000.0;
+    sim->set_params(sp);
+
+    // Software overhead of one status read with the wire taken out
+    const int n = 2000;
+    const auto t0 = steady_clock::now();
+    for (int i = 0; i < n; ++i) (void)ctrl.read_status();
+    const double us = duration<double, std::micro>(steady_clock::now() - t0).count() / n;
+
+    stress_test_move_relative_blocking(ctrl, 20, 0, 50, 10, 1500, 0);
+    stress_test_move_absolute_blocking(ctrl, 20, 0, 50, 1500, 0);
+
+    // A silent drive: bounded failure
+    sim->set_silent(true);
+    assert(ctrl.read_status().timestamp == steady_clock::time_point());
+    sim->set_silent(false);
+    ctrl.disconnect();
+    std::cout << "[simulator-test] ok read_us=" << us << " requests=" << sim->requests()
+              << " moves=" << sim->moves() << std::endl;
+}
+
+// End to end over a pty against the emulator: wire time, travel, injected faults
+static void run_emulator_test() {
+    using namespace std::chrono;
+    pty_emulator::options opt;
+    opt.drive.units_per_second = 1000.0;
+    pty_emulator emu(opt);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    ctrl.set_status_bits({0x0001, 0x0002, 0x0004});
+    assert(ctrl.connect(emu.port()) == 0);
+    assert(ctrl.move_relative_blocking(5, 10, 2, 0) == 0 && emu.drive().position() == 5);
+    assert(ctrl.move_absolute_blocking(12, 20, 2, 0) == 0 && ctrl.get_current_position() == 12);
+
+    // A two-register status read is 8 + 9 bytes on the wire: 4.4 ms at 38400
+    auto t0 = steady_clock::now();
+    assert(ctrl.read_status().position == 12);
+    assert(steady_clock::now() - t0 >= microseconds(4400));
+
+    const act_controller::serial_bus::rx_stats before = ctrl.framing_stats();
+    emu.set_faults({0.0, 1.0, 0.0, 7});
+    assert(ctrl.read_status().timestamp == steady_clock::time_point());
+    assert(ctrl.framing_stats().parser.crc_errors > before.parser.crc_errors);
+    emu.set_faults({1.0, 0.0, 0.0, 7});
+    assert(ctrl.read_status().timestamp == steady_clock::time_point());
+    emu.set_faults({0.0, 0.0, 1.0, 7});
+    assert(ctrl.read_status().timestamp == steady_clock::time_point());
+    emu.set_faults({});
+    assert(ctrl.read_status().position == 12);
+    const pty_emulator::stats st = emu.get_stats();
+    assert(st.bad_crcs > 0 && st.dropped_bytes > 0 && st.silenced > 0);
+    ctrl.disconnect();
+
+    // A drive fixed at 115200 is found by rate detection
+    opt.baud = 115200;
+    pty_emulator fast(opt);
+    act_controller ctrl2;
+    ctrl2.set_port_cache_path("");
+    act_controller::line_settings line;
+    line.auto_detect = true;
+    ctrl2.set_line_settings(line);
+    assert(ctrl2.connect(fast.port()) == 0 && ctrl2.get_baud_rate() == 115200);
+    assert(fast.get_stats().noise_bytes > 0);
+    ctrl2.disconnect();
+    std::cout << "[emulator-test] ok requests=" << st.requests << std::endl;
+}
+
+// Record a session over the emulator, read it back, replay it against its own replies
+static void run_capture_test() {
+    using namespace std::chrono;
+    using cap = act_controller::wire_capture;
+    const std::string path = "/tmp/act_controller_test_capture";
+    pty_emulator::options opt;
+    opt.drive.units_per_second = 1000.0;
+    pty_emulator emu(opt);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    ctrl.set_status_bits({0x0001, 0x0002, 0x0004});
+    assert(ctrl.connect(emu.port()) == 0);
+    assert(ctrl.start_capture(path));
+    assert(ctrl.get_current_position() == 0);
+    assert(ctrl.move_relative_blocking(3, 10, 2, 0) == 0);
+    emu.set_faults({0.0, 1.0, 0.0, 3});
+    assert(ctrl.read_status().timestamp == steady_clock::time_point());
+    emu.set_faults({});
+    assert(ctrl.read_status().position == 3);
+    const cap::stats st = ctrl.stop_capture();
+    assert(st.records > 0 && st.dropped == 0);
+    assert(ctrl.capture_stats().records == 0);
+
+    cap::reader rd;
+    assert(rd.load(path) && rd.baud() == act_controller::k_default_baud && rd.version() == cap::k_version);
+    assert(rd.records().size() == st.records);
+    std::size_t tx = 0, results = 0, bad_rx = 0, moves = 0;
+    nanoseconds last{0};
+    for (const auto& r : rd.records()) {
+        assert(r.t >= last);
+        last = r.t;
+        if (r.dir == cap::kind::tx) {
+            ++tx;
+            assert(r.crc == cap::crc_state::ok && test_crc16_modbus(r.data.data(), r.data.size()) == 0);
+            if (r.op == act_controller::wire_op::move_relative) ++moves;
+        }
+        if (r.dir == cap::kind::result) ++results;
+        if (r.dir == cap::kind::rx && r.crc == cap::crc_state::bad) ++bad_rx;
+    }
+    assert(tx > 0 && results == tx && bad_rx > 0 && moves >= 2);
+
+    // Same outcomes, bad CRC included, at the recorded pace and back to back
+    const auto rep = act_controller::replay_capture(path, 1.0);
+    assert(rep && rep->transactions == tx && rep->same_outcome == tx);
+    assert(rep->outcomes[static_cast<std::size_t>(act_controller::reply_status::crc_error)] == 2); // try + retry
+    const auto fast = act_controller::replay_capture(path, 0.0);
+    assert(fast && fast->same_outcome == tx);
+    assert(!act_controller::replay_capture("/tmp/act_controller_test_no_capture"));
+
+    // A capture from a newer format version is refused rather than misread
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        bytes[8] = static_cast<char>(cap::k_version + 1);
+        const std::string newer = path + ".v" + std::to_string(cap::k_version + 1);
+        std::ofstream(newer, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        cap::reader future;
+        assert(!future.load(newer));
+        std::remove(newer.c_str());
+    }
+
+    // A full capture drops records instead of growing
+    assert(ctrl.start_capture(path, 64));
+    (void)ctrl.read_status();
+    (void)ctrl.read_status();
+    assert(ctrl.stop_capture().dropped > 0);
+    ctrl.disconnect();
+    std::remove(path.c_str());
+    std::cout << "[capture-test] ok records=" << st.records << " bytes=" << st.bytes
+              << " recorded_p50_us=" << rep->recorded_p50.count() << " replay_p50_us=" << rep->replay_p50.count()
+              << std::endl;
+}
+
+static void run_metrics_test() {
+    using namespace std::chrono;
+    using hist = act_controller::latency_histogram;
+    // Every value lands in a bucket whose top is within 1/16 above it
+    for (uint64_t v = 0; v < (uint64_t(1) << 34); v = v * 9 / 8 + 1) {
+        const std::size_t b = hist::bucket_of(v);
+        assert(b < hist::k_buckets);
+        if (v < (uint64_t(1) << hist::k_max_exp)) assert(hist::bucket_high(b) >= v && hist::bucket_high(b) <= v + v / 16);
+    }
+    hist h;
+    for (int i = 1; i <= 1000; ++i) h.record(microseconds(i));
+    const hist::summary hs = h.get();
+    assert(hs.samples == 1000 && hs.max == microseconds(1000) && hs.mean == microseconds(500));
+    assert(hs.p50 >= microseconds(500) && hs.p50 <= microseconds(532));
+    assert(hs.p99 >= microseconds(990) && hs.p99 <= microseconds(1000));
+
+    auto sim = std::make_shared<act_controller::simulated_actuator>();
+    act_controller ctrl(act_controller::simulated(sim));
+    ctrl.set_status_bits({0x0001, 0x0002, 0x0004});
+    assert(ctrl.connect("sim") == 0);
+    using op = act_controller::wire_op;
+    auto ops = [](const act_controller::metrics_report& m, op o) { return m.commands[static_cast<std::size_t>(o)]; };
+    act_controller::metrics_report m = ctrl.metrics_snapshot();
+    assert(ops(m, op::probe).samples == 1 && ops(m, op::init).samples == 0 && m.connects == 1);
+    for (const auto& step : m.init_steps) assert(step.samples == 1);
+    for (int i = 0; i < 50; ++i) (void)ctrl.get_current_position();
+    for (int d : {2, -1, 3}) assert(ctrl.move_relative_blocking(d, 30, 2, 0) == 0);
+    m = ctrl.metrics_snapshot();
+    const auto pos = ops(m, op::position);
+    assert(pos.samples >= 50 && pos.p50 <= pos.p99 && pos.p99 <= pos.max);
+    assert(ops(m, op::move_relative).samples == 3 && m.settle.samples == 3);
+    assert(m.transactions == m.transaction.samples && m.timeouts == 0);
+
+    sim->set_silent(true);
+    (void)ctrl.read_status();
+    sim->set_silent(false);
+    ctrl.disconnect();
+    assert(ctrl.connect("sim") == 0);
+    m = ctrl.metrics_snapshot();
+    assert(m.timeouts == 2 && m.retries == 1 && m.reconnects == 1);
+
+    const std::string text = act_controller::metrics_text(m, "arm=\"1\"");
+    assert(text.find("act_command_latency_us{op=\"position\",quantile=\"0.99\",arm=\"1\"} ") != std::string::npos);
+    assert(text.find("act_command_latency_us_count{op=\"init\",step=\"0\",arm=\"1\"} 2\n") != std::string::npos);
+    assert(text.find("act_command_latency_us_count{op=\"init\",step=\"19\",arm=\"1\"} 2\n") != std::string::npos);
+    assert(text.find("act_timeouts_total{arm=\"1\"} 2\n") != std::string::npos);
+    const std::string path = "/tmp/act_controller_test_metrics.prom";
+    assert(ctrl.write_metrics(path));
+    std::ifstream in(path);
+    const std::string file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    assert(file.find("act_reconnects_total 1\n") != std::string::npos);
+    std::remove(path.c_str());
+    ctrl.reset_metrics();
+    assert(ctrl.metrics_snapshot().transaction.samples == 0);
+    ctrl.disconnect();
+    std::cout << "[metrics-test] ok position_p50_us=" << pos.p50.count() << " p99_us=" << pos.p99.count()
+              << " settle_p50_us=" << m.settle.p50.count() << std::endl;
+}
+
+// Several simulated arms at once: every workload, repeatable per seed, measured
+static void run_stress_engine_test() {
+    using namespace std::chrono;
+    act_controller::simulated_actuator::params sp;
+    sp.units_per_second = 100000.0;
+    std::vector<std::shared_ptr<act_controller::simulated_actuator>> sims;
+    std::vector<std::unique_ptr<act_controller>> ctrls;
+    std::vector<act_controller*> arms;
+    for (int i = 0; i < 3; ++i) {
+        sims.push_back(std::make_shared<act_controller::simulated_actuator>(sp));
+        ctrls.push_back(std::make_unique<act_controller>(act_controller::simulated(sims.back())));
+        ctrls.back()->set_status_bits({0x0001, 0x0002, 0x0004});
+        assert(ctrls.back()->connect("sim") == 0);
+        arms.push_back(ctrls.back().get());
+    }
+    stress_engine::config cfg;
+    cfg.iterations = 12;
+    cfg.seed = 7;
+    cfg.tolerance = 0;
+
+    // Same seed, same targets: the arms end where they ended the first time
+    const stress_engine::report abs1 = stress_engine::run(arms, stress_engine::random_absolute(0, 50), cfg);
+    std::vector<int> first;
+    for (const auto& s : sims) first.push_back(s->position());
+    assert(abs1.arms.size() == 3 && abs1.steps == 36 && abs1.pass == 36 && abs1.fail == 0);
+    assert(first[0] != first[1] || first[1] != first[2]); // each arm has its own sequence
+    for (auto* a : arms) assert(a->move_absolute_blocking(0, 30, 2, 0) == 0);
+    const stress_engine::report abs2 = stress_engine::run(arms, stress_engine::random_absolute(0, 50), cfg);
+    for (std::size_t i = 0; i < sims.size(); ++i) assert(sims[i]->position() == first[i]);
+    assert(abs2.pass == 36 && abs2.settle.samples == 36 && abs2.steps_per_second > 0);
+    for (const auto& a : abs2.arms) {
+        const auto& cmd = a.metrics.commands[static_cast<std::size_t>(act_controller::wire_op::move_absolute)];
+        assert(cmd.samples == 12 && a.settle.samples == 12 && a.settle.p50 <= a.settle.max);
+        assert(a.metrics.transactions > 0 && a.metrics.timeouts == 0);
+        assert(a.bus_utilization > 0 && a.bus_utilization < 1);
+    }
+    // The run is measured from a mark: the arms' own histograms keep both runs and the move between
+    for (auto* a : arms)
+        assert(a->metrics_snapshot().commands[static_cast<std::size_t>(act_controller::wire_op::move_absolute)].samples == 25);
+    stress_engine::print(abs2);
+
+    // Press cycles alternate between the two ends
+    cfg.iterations = 4;
+    const stress_engine::report press = stress_engine::run(arms, stress_engine::press_cycle(5, 40, 30), cfg);
+    assert(press.pass == 12);
+    for (const auto& s : sims) assert(s->position() == 5);
+
+    // Relative moves carry their frame pauses, so only a few
+    cfg.iterations = 3;
+    const stress_engine::report rel =
+        stress_engine::run(arms, stress_engine::random_relative(0, 50, 10), cfg);
+    assert(rel.pass == 9 && rel.settle.samples == 9);
+    assert(stress_test_move_relative(*arms[0], 2, 0, 50, 10, 1500, 0).fail == 0);
+
+    // Connect churn reconnects every arm to its own device
+    cfg.iterations = 5;
+    const stress_engine::report churn = stress_engine::run(arms, stress_engine::connect_churn(milliseconds(1)), cfg);
+    assert(churn.pass == 15);
+    for (const auto& a : churn.arms) assert(a.metrics.connects == 5 && a.port == "sim");
+    for (auto* a : arms) assert(a->is_connected());
+    assert(stress_test_connect_disconnect(*arms[0], 2, 1, "sim").pass == 2 && !arms[0]->is_connected());
+    for (auto* a : arms) a->disconnect();
+    std::cout << "[stress-engine-test] ok abs_steps_per_s=" << abs2.steps_per_second
+              << " settle_p99_us=" << abs2.settle.p99.count() << std::endl;
+}
+
+static void run_zero_alloc_test() {
+    using namespace std::chrono;
+    fake_pty_controller live(false, 1000);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    assert(ctrl.connect(live.port()) == 0);
+    int polls = 0;
+    auto cycle = [&](int step) {
+        ctrl.move_relative(step, 20);
+        ctrl.move_absolute(10 + step, 20);
+        (void)ctrl.get_current_position();
+        (void)ctrl.read_status();
+        // Callback form, completed on the I/O thread
+        std::mutex m;
+        std::condition_variable cv;
+        bool done = false;
+        ctrl.async_get_position([&](const asio::error_code& ec, int) {
+            std::lock_guard<std::mutex> lk(m);
+            if (!ec) ++polls;
+            done = true;
+            cv.notify_one();
+        });
+        std::unique_lock<std::mutex> lk(m);
+        cv.wait(lk, [&] { return done; });
+    };
+    // Warm-up fills the block pool, the command ring and asio's per-thread caches
+    for (int i = 0; i < 2; ++i) cycle(i % 2 ? 1 : -1);
+    g_allocs = 0;
+    g_count_allocs = true;
+    for (int i = 0; i < 3; ++i) cycle(i % 2 ? 1 : -1);
+    g_count_allocs = false;
+    const long allocs = g_allocs.load();
+    ctrl.disconnect();
+    std::cout << "[zero-alloc-test] allocations=" << allocs << " polls=" << polls << std::endl;
+    assert(allocs == 0 && polls == 5);
+    std::cout << "[zero-alloc-test] ok" << std::endl;
+}
+
+static void run_fast_absolute_test() {
+    using strings = std::vector<std::string>;
+    fake_pty_controller live(false, 0);
+    act_controller ctrl;
+    ctrl.set_port_cache_path("");
+    assert(ctrl.connect(live.port()) == 0);
+    assert(ctrl.get_absolute_mode() == act_controller::absolute_mode::legacy);
+
+    // Default: the captured sequence
+    int frames0 = live.frames_seen();
+    ctrl.move_absolute(40, 10);
+    assert(live.requests(frames0) == (strings{"10 0411 0001", "10 0412 0002", "05 001A 0000",
+                                             "0F 0010 0008", "05 001A FF00", "05 001A 0000"}));
+    assert(ctrl.get_current_position() == 40);
+
+    // Opt-in fast form: one combined write, then the pulse. The legacy move above left
+    // coil 0x001A OFF, so the leading OFF is skipped.
+    ctrl.set_absolute_mode(act_controller::absolute_mode::fast);
+    frames0 = live.frames_seen();
+    ctrl.move_absolute(30, 10);
+    assert(live.requests(frames0) == (strings{"10 0411 0003", "0F 0010 0008", "05 001A FF00", "05 001A 0000"}));
+    assert(ctrl.get_current_position() == 30);
+
+    // First fast move after a reconnect sends the full post-sequence, leading OFF included
+    ctrl.disconnect();
+    assert(ctrl.connect(live.port()) == 0);
+    frames0 = live.frames_seen();
+    ctrl.move_absolute(20, 10);
+    assert(live.requests(frames0) ==
+           (strings{"10 0411 0003", "05 001A 0000", "0F 0010 0008", "05 001A FF00", "05 001A 0000"}));
+    assert(ctrl.get_current_position() == 20);
+
+    // A controller refusing the combined write gets the legacy sequence, now and later
+    live.set_refuse_combined(true);
+    frames0 = live.frames_seen();
+    ctrl.move_absolute(12, 10);
+    assert(live.requests(frames0) == (strings{"10 0411 0003", "10 0411 0001", "10 0412 0002", "05 001A 0000",
+                                             "0F 0010 0008", "05 001A FF00", "05 001A 0000"}));
+    assert(ctrl.get_current_position() == 12);
+    assert(ctrl.get_absolute_mode() == act_controller::absolute_mode::legacy);
+    ctrl.disconnect();
+    std::cout << "[fast-absolute-test] ok" << std::endl;
+}
+
+// Pool: three arms on two lines, one I/O thread; slots alternate between arms on a line
+static void run_pool_test() {
+    fake_pty_controller line_a(false, 300), line_b(false, 900);
+    act_controller_pool pool(1);
+    pool.add(line_a.port(), 1);
+    pool.add(line_a.port(), 2);
+    pool.add(line_b.port(), 3);
+    assert(pool.size() == 3 && pool.lines() == 2 && pool.io_threads() == 1);
+    assert(pool.connect_all() == 0);
+    // Each arm's init went to its own slave address
+    assert(line_a.frames_seen(1) == 21 && line_a.frames_seen(2) == 21 && line_b.frames_seen(3) == 21);
+    assert(pool[2].get_current_position() == 9);
+
+    // Queue a burst on arm 1, then on arm 2: the shared line serves them alternately
+    std::vector<int> order; // appended on the single I/O thread
+    std::atomic<int> left{20};
+    for (int arm = 0; arm < 2; ++arm)
+        for (int i = 0; i < 10; ++i)
+            pool[arm].async_get_position([&, arm](const asio::error_code& ec, int pos) {
+                assert(!ec && pos == 3);
+                order.push_back(arm);
+                --left;
+            });
+    while (left > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    int run = 1, longest = 1;
+    for (std::size_t i = 1; i < order.size(); ++i) {
+        run = order[i] == order[i - 1] ? run + 1 : 1;
+        longest = std::max(longest, run);
+    }
+    assert(longest <= 2);
+    pool.disconnect_all();
+    std::cout << "[pool-test] ok longest_run=" << longest << std::endl;
+}
+#endif
+
 // Controller connectivity test (will skip if cannot connect)
 static void run_connect_test() {
     act_controller ctrl;
@@ -78,15 +1408,36 @@ static void run_connect_test() {
     std::cout << "[disconnect-test] ok" << std::endl;
 }
 
-// Movement tolerance dry-run (skips if no device)
+// A connected controller: the real arm when one answers, else a simulated one (also
+// returned through `sim` when asked for)
+static std::unique_ptr<act_controller> device_or_simulator(
+    const char* tag, std::shared_ptr<act_controller::simulated_actuator>* sim = nullptr) {
+    auto ctrl = std::make_unique<act_controller>();
+    ctrl->init();
+    if (ctrl->connect() == 0) return ctrl;
+    std::cout << "[" << tag << "] no device, using the simulator" << std::endl;
+    auto drive = std::make_shared<act_controller::simulated_actuator>();
+    if (sim) *sim = drive;
+    ctrl = std::make_unique<act_controller>(act_controller::simulated(drive));
+    assert(ctrl->connect("sim") == 0);
+    return ctrl;
+}
+
+// Movement tolerance dry-run (simulated if no device)
 static void run_movement_blocking_test() {
-    act_controller ctrl;
-    ctrl.init();
-    if (ctrl.connect() != 0) {
-        std::cout << "[movement-test] skipped (no device)" << std::endl;
+    std::shared_ptr<act_controller::simulated_actuator> sim;
+    std::unique_ptr<act_controller> arm = device_or_simulator("movement-test", &sim);
+    act_controller& ctrl = *arm;
+    int start = ctrl.get_current_position();
+    if (sim) {
+        // The 1-unit dry-run below passes within tolerance without moving; with zero
+        // tolerance the simulated arm must have travelled the whole distance
+        const int d = 5;
+        assert(ctrl.move_relative_blocking(d, 10, 5, 0) == 0 && sim->position() == start + d);
+        std::cout << "[movement-test] start=" << start << " after=" << sim->position() << std::endl;
+        ctrl.disconnect();
         return;
     }
-    int start = ctrl.get_current_position();
     int rc = ctrl.move_relative_blocking(1, 10, 5, 2); // 1 unit forward
     int after = ctrl.get_current_position();
     if (rc == 0) {
@@ -98,14 +1449,10 @@ static void run_movement_blocking_test() {
     ctrl.disconnect();
 }
 
-// Absolute movement test (skips if no device)
+// Absolute movement test (simulated if no device)
 static void run_absolute_blocking_test() {
-    act_controller ctrl;
-    ctrl.init();
-    if (ctrl.connect() != 0) {
-        std::cout << "[absolute-test] skipped (no device)" << std::endl;
-        return;
-    }
+    std::unique_ptr<act_controller> arm = device_or_simulator("absolute-test");
+    act_controller& ctrl = *arm;
     int target = 5;
     int rc = ctrl.move_absolute_blocking(target, 8, 1); // tolerance=1
     int pos = ctrl.get_current_position();
@@ -120,6 +1467,33 @@ static void run_absolute_blocking_test() {
 
 int main() {
     run_util_tests();
+    run_frame_builder_tests();
+    run_crc_engine_tests();
+    run_rtu_parser_tests();
+    run_port_ranking_tests();
+#ifndef _WIN32
+    run_discovery_tests();
+    run_fake_connect_test();
+    run_init_sequence_test();
+    run_telemetry_test();
+    run_async_api_test();
+    run_trajectory_test();
+    run_pool_test();
+    run_settle_estimator_test();
+    run_status_read_test();
+    run_framing_test();
+    run_transaction_test();
+    run_baud_test();
+    run_low_latency_test();
+    run_realtime_test();
+    run_simulator_test();
+    run_emulator_test();
+    run_capture_test();
+    run_metrics_test();
+    run_stress_engine_test();
+    run_zero_alloc_test();
+    run_fast_absolute_test();
+#endif
     run_connect_test();
     run_movement_blocking_test();
     run_absolute_blocking_test();